@@ -74,6 +74,8 @@ def amalgamate_source(source_top_dir=None,
     header.add_file("include/json/value.h")
     header.add_file("include/json/reader.h")
     header.add_file("include/json/writer.h")
+    header.add_file("include/json/frozen.h")
+    header.add_file("include/json/columnar.h")
     header.add_file("include/json/assertions.h")
     header.add_text("#endif //ifndef JSON_AMALGATED_H_INCLUDED")
 
@@ -122,6 +124,8 @@ def amalgamate_source(source_top_dir=None,
     source.add_file(os.path.join(lib_json, "json_valueiterator.inl"))
     source.add_file(os.path.join(lib_json, "json_value.cpp"))
     source.add_file(os.path.join(lib_json, "json_writer.cpp"))
+    source.add_file(os.path.join(lib_json, "json_frozen.cpp"))
+    source.add_file(os.path.join(lib_json, "json_columnar.cpp"))
 
     print("Writing amalgated source to %r" % target_source_path)
     source.write_to(target_source_path)
@@ -0,0 +1,165 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef JSON_COLUMNAR_H_INCLUDED
+#define JSON_COLUMNAR_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "value.h"
+#include "reader.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <vector>
+
+// Disable warning C4251: <data member>: <type> needs to have dll-interface to
+// be used by...
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif // if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+
+#pragma pack(push, 8)
+
+// Columns of integers hold 64-bit integers.
+#if defined(JSON_HAS_INT64)
+
+namespace Json {
+
+/** \brief The records of an array as columns, one per member, for scans and
+ * aggregations over many records.
+ *
+ * Each record is an object; the members of objects nested in a record
+ * make columns too, named by the path to them: their names joined with '.',
+ * where a '.' or '\\' in a name is escaped with '\\'. Row i of
+ * every column is record i. A column holds the values of all rows in one
+ * buffer of its type, and a bitmap telling the rows that hold one: a row
+ * whose record lacks the member, or holds null there, is null, and holds 0
+ * or an empty string in the buffer.
+ *
+ * The view copies what it needs: it does not refer to the array once
+ * built.
+ *
+ * Example of usage:
+ * \code
+ * Json::ColumnarView sales(root["sales"]);
+ * const Json::ColumnarView::Column* amount = sales.find("amount");
+ * double total = 0;
+ * if (amount && amount->type() == Json::realValue)
+ *   for (Json::ArrayIndex row = 0; row < sales.rows(); ++row)
+ *     total += amount->reals()[row];
+ * \endcode
+ */
+class JSON_API ColumnarView {
+public:
+  class Column;
+
+  /// A view of no records.
+  ColumnarView();
+  /// \pre records is an array or null. Elements that are not objects make
+  /// rows where every column is null.
+  explicit ColumnarView(const Value& records);
+  ColumnarView(const ColumnarView& other);
+#if JSON_HAS_RVALUE_REFERENCES
+  ColumnarView(ColumnarView&& other);
+#endif
+  ~ColumnarView();
+  ColumnarView& operator=(ColumnarView other);
+  void swap(ColumnarView& other);
+
+  /// Parse [begin, end), an array of records, with a reader made by builder,
+  /// then make its columns.
+  /// \return false, leaving view unchanged, if the document is not valid.
+  static bool parse(const CharReaderBuilder& builder, char const* begin,
+                    char const* end, ColumnarView* view, JSONCPP_STRING* errs);
+
+  /// Number of records.
+  ArrayIndex rows() const;
+  /// Number of columns, in the order their members were first met.
+  ArrayIndex columns() const;
+  /// \pre index < columns()
+  const Column& operator[](ArrayIndex index) const;
+  /// \return the column at path, or NULL if there is none.
+  const Column* find(const char* path) const;
+  const Column* find(const JSONCPP_STRING& path) const;
+
+private:
+  struct Builder;
+
+  ArrayIndex rows_;
+  std::vector<Column*> columns_;
+};
+
+/** \brief The values of one member in all the records of a ColumnarView.
+ *
+ * type() tells the buffer holding them:
+ * - booleanValue: bools(), a byte of 0 or 1 per row;
+ * - intValue: ints(), when all of them are integers in the range of Int64;
+ * - uintValue: uints(), when all of them are non-negative integers, some
+ *   beyond that range;
+ * - realValue: reals(), when the numbers need a double;
+ * - stringValue: the characters of each row one after the other in chars(),
+ *   row i from offsets()[i] to offsets()[i + 1];
+ * - nullValue: none, as all rows are null.
+ *
+ * Members holding arrays, or values of several of these kinds, do not make
+ * a column. Members holding objects make the columns of their own members
+ * instead; if they hold other values in some records, those are left out.
+ */
+class JSON_API ColumnarView::Column {
+public:
+  /// Names of the members leading to the values, joined with '.'. A '.' or
+  /// '\\' in a name is escaped with '\\': member "a.b" has path "a\\.b",
+  /// and member "b" of member "a" has path "a.b".
+  const JSONCPP_STRING& path() const;
+  ValueType type() const;
+  /// Number of rows, the same for all columns.
+  ArrayIndex size() const;
+
+  /// \return whether the record of row lacks the member, or holds null.
+  bool isNull(ArrayIndex row) const;
+  /// Bit (row % 64) of word (row / 64) is set if row is not null.
+  const UInt64* validity() const;
+
+  /// \return the values, or NULL if the column is not of that type.
+  const unsigned char* bools() const;
+  const Int64* ints() const;
+  const UInt64* uints() const;
+  const double* reals() const;
+  const char* chars() const;
+  /// size() + 1 offsets into chars(), for a stringValue column.
+  const UInt64* offsets() const;
+  /// Get the string of row, without copying it.
+  /// \return false if the column does not hold strings.
+  bool getString(ArrayIndex row, char const** begin, char const** end) const;
+
+  /// \return the value of row as a Value; null if the row is null.
+  Value value(ArrayIndex row) const;
+
+private:
+  friend class ColumnarView;
+  Column(const JSONCPP_STRING& path, ValueType type, ArrayIndex rows);
+
+  JSONCPP_STRING path_;
+  ValueType type_;
+  ArrayIndex size_;
+  std::vector<UInt64> validity_;
+  std::vector<unsigned char> bools_;
+  std::vector<Int64> ints_;
+  std::vector<UInt64> uints_;
+  std::vector<double> reals_;
+  std::vector<char> chars_;
+  std::vector<UInt64> offsets_;
+};
+
+} // namespace Json
+
+#endif // if defined(JSON_HAS_INT64)
+
+#pragma pack(pop)
+
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+#pragma warning(pop)
+#endif // if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+
+#endif // JSON_COLUMNAR_H_INCLUDED
@@ -32,6 +32,13 @@ class ValueIteratorBase;
 class ValueIterator;
 class ValueConstIterator;
 
+// frozen.h
+class FrozenNode;
+class FrozenValue;
+
+// columnar.h
+class ColumnarView;
+
 } // namespace Json
 
 #endif // JSON_FORWARDS_H_INCLUDED
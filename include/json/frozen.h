@@ -0,0 +1,258 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#ifndef JSON_FROZEN_H_INCLUDED
+#define JSON_FROZEN_H_INCLUDED
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include "value.h"
+#include "reader.h"
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <iterator>
+#include <vector>
+
+// Disable warning C4251: <data member>: <type> needs to have dll-interface to
+// be used by...
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+#pragma warning(push)
+#pragma warning(disable : 4251)
+#endif // if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+
+#pragma pack(push, 8)
+
+// The tape is made of 64-bit words.
+#if defined(JSON_HAS_INT64)
+
+namespace Json {
+
+/** \brief Read-only view of a value in a FrozenValue.
+ *
+ * A node only points into the tape of its FrozenValue, so it is cheap to
+ * copy, and valid until that FrozenValue is destroyed or assigned to. The
+ * accessors mirror those of Value, and convert by the same rules.
+ */
+class JSON_API FrozenNode {
+public:
+  class const_iterator;
+
+  /// A null node, part of no FrozenValue.
+  FrozenNode();
+
+  ValueType type() const;
+  bool isNull() const;
+  bool isBool() const;
+  bool isInt() const;
+  bool isInt64() const;
+  bool isUInt() const;
+  bool isUInt64() const;
+  bool isIntegral() const;
+  bool isDouble() const;
+  bool isNumeric() const;
+  bool isString() const;
+  bool isArray() const;
+  bool isObject() const;
+
+  /// \return the string, null-terminated; it may contain embedded nulls.
+  /// \pre type() is stringValue
+  const char* asCString() const;
+  /// Get the string of a stringValue, without copying it.
+  /// \return false if not a string.
+  bool getString(char const** begin, char const** end) const;
+  JSONCPP_STRING asString() const;
+  Int asInt() const;
+  UInt asUInt() const;
+  Int64 asInt64() const;
+  UInt64 asUInt64() const;
+  LargestInt asLargestInt() const;
+  LargestUInt asLargestUInt() const;
+  float asFloat() const;
+  double asDouble() const;
+  bool asBool() const;
+
+  /// Number of elements of an array, or of members of an object; 0 for any
+  /// other value.
+  ArrayIndex size() const;
+  bool empty() const;
+
+  /// Element at index, in constant time. A null node if index >= size().
+  FrozenNode operator[](ArrayIndex index) const;
+  FrozenNode operator[](int index) const;
+  /// Member named key, found by a binary search. A null node if there is
+  /// none.
+  FrozenNode operator[](const char* key) const;
+  FrozenNode operator[](const JSONCPP_STRING& key) const;
+  /// Find the member named [begin, end), which may contain embedded nulls.
+  /// \return false if there is none, or this is not an object.
+  bool find(const char* begin, const char* end, FrozenNode* member) const;
+  bool isMember(const char* key) const;
+  bool isMember(const JSONCPP_STRING& key) const;
+
+  /// Iterate over the elements of an array, or the members of an object in
+  /// name order. Empty for any other value.
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  /// Copy this value, and everything under it, into a Value.
+  Value toValue() const;
+
+protected:
+  FrozenNode(const UInt64* tape, size_t index);
+
+  const UInt64* tape_;
+  size_t index_;
+
+private:
+  UInt64 payload() const;
+  Value scalar() const;
+};
+
+/** \brief Iterator over the elements or members of a FrozenNode.
+ */
+class JSON_API FrozenNode::const_iterator {
+public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef FrozenNode value_type;
+  typedef ptrdiff_t difference_type;
+  typedef const FrozenNode* pointer;
+  typedef FrozenNode reference;
+
+  const_iterator();
+
+  FrozenNode operator*() const;
+  const_iterator& operator++();
+  const_iterator operator++(int);
+  bool operator==(const const_iterator& other) const {
+    return entry_ == other.entry_ && tape_ == other.tape_;
+  }
+  bool operator!=(const const_iterator& other) const {
+    return !(*this == other);
+  }
+
+  /// Return the index of the element, or -1 if not iterating an array.
+  UInt index() const;
+  /// Return the name of the member, or "" if not iterating an object.
+  JSONCPP_STRING name() const;
+  /// Return the name of the member, null-terminated, or NULL if not
+  /// iterating an object. Allows embedded nulls.
+  char const* memberName(char const** end) const;
+
+private:
+  friend class FrozenNode;
+  const_iterator(const UInt64* tape, size_t first, size_t entry, bool object);
+
+  const UInt64* tape_;
+  size_t first_;
+  size_t entry_;
+  bool object_;
+};
+
+/** \brief Immutable document laid out flat, for documents read far more
+ * often than they are changed.
+ *
+ * All of the document sits in one allocation: a tape of tagged 64-bit
+ * words, with the index of every element of an array and the name of every
+ * member of an object next to its array or object, followed by the
+ * strings. Indexing an array is done in constant time, and looking up a
+ * member by a binary search over the names, in name order. Member names
+ * used in several objects are stored once.
+ *
+ * Example of usage:
+ * \code
+ * Json::FrozenValue config;
+ * JSONCPP_STRING errs;
+ * if (!Json::FrozenValue::parse(builder, begin, end, &config, &errs))
+ *   return false;
+ * for (Json::FrozenNode server : config["servers"])
+ *   connect(server["host"].asString(), server["port"].asUInt());
+ * \endcode
+ */
+class JSON_API FrozenValue : public FrozenNode {
+public:
+  /// A null value.
+  FrozenValue();
+  explicit FrozenValue(const Value& value);
+  FrozenValue(const FrozenValue& other);
+#if JSON_HAS_RVALUE_REFERENCES
+  FrozenValue(FrozenValue&& other);
+#endif
+  FrozenValue& operator=(FrozenValue other);
+  void swap(FrozenValue& other);
+
+  /// Parse [begin, end) with a reader made by builder, then freeze the
+  /// document.
+  /// \return false, leaving root unchanged, if the document is not valid.
+  static bool parse(const CharReaderBuilder& builder, char const* begin,
+                    char const* end, FrozenValue* root, JSONCPP_STRING* errs);
+
+  /// Size in bytes of the tape and strings.
+  size_t byteSize() const;
+
+  /// Write the tape and strings as they are, after a small header, to be
+  /// mapped back by FrozenSnapshot. out should be opened in binary mode;
+  /// its state tells whether writing failed.
+  void writeSnapshot(JSONCPP_OSTREAM& out) const;
+
+private:
+  void attach();
+
+  std::vector<UInt64> buffer_;
+};
+
+/** \brief FrozenValue mapped read-only from a file written by
+ * FrozenValue::writeSnapshot().
+ *
+ * Nothing is read up front: nodes point straight into the mapping, so
+ * opening a snapshot takes the same time whatever its size, and processes
+ * mapping the same file share its pages. Snapshots can only be opened on a
+ * machine of the same byte order. They are trusted: opening one checks
+ * its header and size, not its contents.
+ *
+ * \code
+ * Json::FrozenSnapshot dataset;
+ * JSONCPP_STRING errs;
+ * if (!dataset.open("reference.tape", &errs))
+ *   throw std::runtime_error(errs);
+ * double rate = dataset["rates"]["EUR"].asDouble();
+ * \endcode
+ */
+class JSON_API FrozenSnapshot : public FrozenNode {
+public:
+  /// A null value, mapping nothing.
+  FrozenSnapshot();
+  ~FrozenSnapshot();
+#if JSON_HAS_RVALUE_REFERENCES
+  FrozenSnapshot(FrozenSnapshot&& other);
+#endif
+  void swap(FrozenSnapshot& other);
+
+  /// Map the snapshot in the file at path, after unmapping any other.
+  /// \return false, leaving this unchanged, if the file cannot be mapped
+  /// or does not hold a snapshot.
+  bool open(const char* path, JSONCPP_STRING* errs);
+  /// Unmap the snapshot, leaving a null value.
+  void close();
+
+  /// Size in bytes of the tape and strings.
+  size_t byteSize() const;
+
+private:
+  FrozenSnapshot(const FrozenSnapshot&);            // not implemented
+  FrozenSnapshot& operator=(const FrozenSnapshot&); // not implemented
+
+  void* mapping_;
+  size_t length_;
+};
+
+} // namespace Json
+
+#endif // if defined(JSON_HAS_INT64)
+
+#pragma pack(pop)
+
+#if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+#pragma warning(pop)
+#endif // if defined(JSONCPP_DISABLE_DLL_INTERFACE_WARNING)
+
+#endif // JSON_FROZEN_H_INCLUDED
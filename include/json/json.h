@@ -10,5 +10,7 @@
 #include "value.h"
 #include "reader.h"
 #include "writer.h"
+#include "frozen.h"
+#include "columnar.h"
 
 #endif // JSON_JSON_H_INCLUDED
@@ -262,7 +262,8 @@ public:
    document to read.
    *        Must be >= beginDoc.
    * \param root [out] Contains the root value of the document if it was
-   *             successfully parsed.
+   *             successfully parsed. If root was made with an Arena, the
+   *             document is built in it.
    * \param errs [out] Formatted error messages (if not NULL)
    *        a user friendly string that lists errors in the parsed
    * document.
@@ -306,6 +307,12 @@ public:
       - true to collect comment and allow writing them
         back during serialization, false to discard comments.
         This parameter is ignored if allowComments is false.
+    - `"collectOffsets": false or true`
+      - true to record the range of the input from which each value was
+        parsed (see Value::getOffsetStart()), false (the default) to leave
+        the offsets 0. Offsets live in a side table: true gives every
+        parsed value a record there, taken under a lock, which costs time
+        as well as memory on large documents.
     - `"allowComments": false or true`
       - true if comments are allowed.
     - `"strictRoot": false or true`
@@ -329,6 +336,45 @@ public:
     - `"allowSpecialFloats": false or true`
       - If true, special float values (NaNs and infinities) are allowed 
         and their values are lossfree restorable.
+    - `"internKeys": false or true`
+      - If true, object member names are stored once in the KeyPool and
+        shared by all the objects that use them. Names the pool cannot take,
+        as it is bounded, are copied as usual.
+    - `"sizeHints": false or true`
+      - If true, each array or object reserves room for as many elements as
+        the previous one at the same depth had (see Value::reserve()). This
+        suits documents made of similar records.
+    - `"lazyNumbers": false or true`
+      - If true, real numbers keep their source text and are only decoded
+        when their value is first used. Writers output that text as is
+        (see Value::getNumberText()).
+    - `"lazyStrings": false or true`
+      - If true, strings keep their escaped source text, and are only
+        unescaped when their value is first used. Writers output that text
+        as is (see Value::getRawString()) when it is the one they would
+        write for the string, and escape the string otherwise.
+    - `"reuseValues": false or true`
+      - If true, `parse()` reads the document over the one the root already
+        holds: arrays, objects and strings found at the same place are
+        overwritten in place instead of being freed and allocated again.
+        This suits loops that parse many documents of the same shape.
+    - `"packNumbers": false or true`
+      - If true, arrays of at least 16 integers, or of at least 16 reals,
+        hold their numbers contiguously rather than as Values (see
+        Value::getPackedReals()). Writers read them as they are. They are
+        boxed into Values the first time an element is accessed as one,
+        by operator[] or an iterator: the array then holds both, taking
+        three times the room it did packed, until it is modified. Numbers
+        with comments, source offsets or source text kept by "lazyNumbers"
+        are not packed: leave "collectOffsets" false as well.
+    - `"shareShapes": false or true`
+      - If true, objects read in a row at the same depth with the same
+        member names, as the records of an array, share them from the
+        second one on, and only hold the values of their members. An object
+        with other names leaves the names shared so far in place, unless
+        the next object has them too. Adding or removing a member gives the
+        object its own names back. The reader keeps the last shape at each
+        depth across documents.
 
     You can examine 'settings_` yourself
     to see the defaults. You can also write and read them just like any
@@ -355,6 +401,8 @@ public:
    * \pre 'settings' != NULL (but Json::null is fine)
    * \remark Defaults:
    * \snippet src/lib_json/json_reader.cpp ReaderBuilderDefaults
+   * \remark "collectOffsets" is off by default: turning it on gives every
+   * parsed value a side-table record, taken under a lock.
    */
   static void setDefaults(Json::Value* settings);
   /** Same as old Features::strictMode().
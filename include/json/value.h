@@ -12,12 +12,11 @@
 #include <string>
 #include <vector>
 #include <exception>
+#include <atomic>
+#include <functional>
+#include <utility>
 
-#ifndef JSON_USE_CPPTL_SMALLMAP
 #include <map>
-#else
-#include <cpptl/smallmap.h>
-#endif
 #ifdef JSON_USE_CPPTL
 #include <cpptl/forwards.h>
 #endif
@@ -140,6 +139,199 @@ private:
   const char* c_str_;
 };
 
+/** \brief Process-wide pool of interned object member names.
+ *
+ * Documents made of many records with the same member names pay for a copy
+ * of every name in every record. An interned name is stored once and shared,
+ * like a StaticString, by all the objects that use it: a member then costs a
+ * pointer, and names compare equal without a memcmp().
+ *
+ * The pool is thread-safe. Its names are never freed, so it is bounded
+ * (see maxSize, maxNameLength and maxBytes) and should only be used for a
+ * bounded vocabulary of names. Names it cannot take are copied as usual.
+ * It is opt-in: see setEnabled() and the "internKeys" setting of
+ * CharReaderBuilder.
+ */
+class JSON_API KeyPool {
+public:
+  /// Upper bound on the number of names in the pool.
+  static const size_t maxSize = 65536;
+  /// Upper bound on the length of a name in the pool.
+  static const size_t maxNameLength = 1024;
+  /// Upper bound on the bytes taken by the names in the pool.
+  static const size_t maxBytes = 4 * 1024 * 1024;
+
+  /// \return the interned, null-terminated copy of [begin, end), or NULL if
+  /// it cannot be interned (embedded zeroes, longer than maxNameLength, or
+  /// the pool is full).
+  static char const* intern(char const* begin, char const* end);
+
+  /// When enabled, Value::operator[] interns the names of the members it
+  /// inserts, and Key interns its name. Disabled by default.
+  static void setEnabled(bool enabled);
+  static bool isEnabled();
+
+  /// Number of names in the pool.
+  static size_t size();
+};
+
+/** \brief A member name prepared for repeated lookups.
+ *
+ * A Key computes the length and hash of a name once, so looking it up in
+ * many objects needs neither a strlen() nor, in objects large enough to be
+ * indexed, a chain of string comparisons. While the KeyPool is enabled, the
+ * name is interned there when possible: members inserted through the Key
+ * then share it, and compare to the names of objects read with
+ * "internKeys" by pointer. Otherwise the Key keeps a copy of its own.
+ *
+ * Example of usage:
+ * \code
+ * static const Json::Key id("id");
+ * for (Json::ArrayIndex i = 0; i < events.size(); ++i)
+ *   ids.insert(events[i][id].asString());
+ * \endcode
+ */
+class JSON_API Key {
+public:
+  explicit Key(const char* name);
+  /// \param begin may contain embedded nulls.
+  Key(const char* begin, const char* end);
+  explicit Key(const JSONCPP_STRING& name);
+  Key(const Key& other);
+  Key& operator=(const Key& other);
+
+  /// \return the name, null-terminated.
+  const char* data() const { return name_; }
+  unsigned length() const { return length_; }
+  UInt hash() const { return hash_; }
+  /// \return true if the name lives in the KeyPool, false if in this Key.
+  bool isInterned() const { return interned_; }
+
+private:
+  void init(const char* begin, const char* end);
+
+  const char* name_;
+  unsigned length_;
+  UInt hash_;
+  bool interned_;
+  JSONCPP_STRING storage_;
+};
+
+/** \brief Monotonic allocator holding whole documents.
+ *
+ * A Value made with an Arena (see Value(Arena&, ValueType)) keeps its
+ * arrays, objects, member names and strings in the arena, and so does
+ * everything stored into it afterwards: values assigned, appended or
+ * inserted are copied into the arena, and a CharReader parsing into it
+ * builds the whole document there, in parse order. Allocating is a pointer
+ * bump, and destroying such values frees nothing: release() frees the whole
+ * document at once.
+ *
+ * Copies made outside of the arena of its values are deep copies, which
+ * outlive it. Values holding storage of the arena, including those moved
+ * out of it, must be destroyed before it is released and not used after.
+ * An Arena is not thread-safe: its documents are built by one thread at a
+ * time, though they may be read from several once built.
+ *
+ * Example of usage:
+ * \code
+ * Json::Arena arena;
+ * for (size_t i = 0; i < documents.size(); ++i) {
+ *   {
+ *     Json::Value root(arena);
+ *     if (reader->parse(documents[i].begin, documents[i].end, &root, &errs))
+ *       process(root);
+ *   }
+ *   arena.release();
+ * }
+ * \endcode
+ */
+class JSON_API Arena {
+public:
+  /// Upper bound on the number of arenas alive at once.
+  static const unsigned maxArenas = 4095;
+
+  /// \param chunkSize bytes obtained from the heap at a time; larger
+  /// allocations get a chunk of their own.
+  explicit Arena(size_t chunkSize = 64 * 1024);
+  ~Arena();
+
+  /// \return size bytes, aligned for any payload of a Value.
+  void* allocate(size_t size) {
+    size = (size + alignment - 1) & ~(alignment - 1);
+    if (size > static_cast<size_t>(limit_ - next_))
+      return allocateChunk(size);
+    void* block = next_;
+    next_ += size;
+    used_ += size;
+    return block;
+  }
+  /// Free everything allocated so far, keeping the last chunk for reuse.
+  void release();
+  /// Bytes handed out since construction or the last release().
+  size_t bytesUsed() const { return used_; }
+  /// \return the number by which values refer to this arena, distinct from
+  /// those of the other arenas alive.
+  unsigned id() const { return id_; }
+
+private:
+  Arena(const Arena&);            // not implemented
+  Arena& operator=(const Arena&); // not implemented
+  friend class Value;
+
+  static const size_t alignment = 8;
+  struct Chunk;
+
+  static Arena* byId(unsigned id);
+  void* allocateChunk(size_t size);
+
+  Chunk* chunks_;
+  char* next_;
+  char* limit_;
+  size_t chunkSize_;
+  size_t used_;
+  unsigned id_;
+  // Handles of the comments and offsets of the values of the arena, which
+  // release() gives back to the side table.
+  std::vector<UInt> extras_;
+};
+
+template <typename T> class ArenaAllocator;
+
+/** \brief Destroy a Value on a background thread.
+ *
+ * Destroying a large document walks and frees the whole tree, which the
+ * thread dropping it may not afford. deferredRelease() instead moves the
+ * value to a queue that a background thread empties. Values whose
+ * destruction is cheap (all but arrays and objects, those still shared with
+ * other copies, and those of an Arena) are destroyed on the spot, and so
+ * are all values while the queue is full.
+ *
+ * \code
+ * Json::deferredRelease(std::move(response));
+ * \endcode
+ */
+JSON_API void deferredRelease(Value&& value);
+
+/// Counters and settings of deferredRelease(). Thread-safe.
+class JSON_API DeferredRelease {
+public:
+  struct Stats {
+    size_t queueDepth;          ///< Values waiting to be destroyed.
+    LargestUInt released;       ///< Values destroyed by the background thread.
+    LargestUInt releasedInPlace; ///< Values destroyed by the calling thread
+                                 ///< instead, the queue being full.
+    LargestUInt reclaimedBytes; ///< Approximate bytes freed in the background.
+  };
+
+  /// Upper bound on the number of values queued. 1024 by default.
+  static void setQueueLimit(size_t limit);
+  static size_t queueLimit();
+  static Stats stats();
+  /// Wait until every value queued so far is destroyed.
+  static void flush();
+};
+
 /** \brief Represents a <a HREF="http://www.json.org">JSON</a> value.
  *
  * This class is a discriminated union wrapper that can represents a:
@@ -161,6 +353,10 @@ private:
  * if it does not exist.
  * The sequence of an #arrayValue will be automatically resized and initialized
  * with #nullValue. resize() can be used to enlarge or truncate an #arrayValue.
+ * Array elements are stored contiguously, so, as with std::vector, growing an
+ * #arrayValue may invalidate references and iterators to its elements.
+ * Likewise, adding or removing a member of an #objectValue may invalidate
+ * references and iterators to its other members.
  *
  * The get() methods can be used to obtain default value in the case the
  * required element does not exist.
@@ -168,6 +364,20 @@ private:
  * It is possible to iterate over the list of a #objectValue values using
  * the getMemberNames() method.
  *
+ * Comments and source offsets are kept in a side table shared by all values,
+ * so a Value that has none is just its payload and type (16 bytes).
+ *
+ * Copying a Value is cheap: copies share its string, array or object payload
+ * until one of them is modified, which then copies the payload one level
+ * deep. Reference counts are atomic, so a Value that is no longer modified
+ * may be copied from several threads at once. A mutable reference obtained
+ * from operator[](), append() or a non-const iterator pins the array or
+ * object it points into: later copies of that Value copy its elements
+ * instead of sharing them. Copying a Value once again yields a fully
+ * shareable one.
+ *
+ * A whole document may be kept in an Arena instead of the heap; see there.
+ *
  * \note #Value string-length fit in size_t, but keys must be < 2^30.
  * (The reason is an implementation detail.) A #CharReader will raise an
  * exception if a bound is exceeded to avoid security holes in your app,
@@ -230,7 +440,7 @@ private:
     CZString(char const* str, unsigned length, DuplicationPolicy allocate);
     CZString(CZString const& other);
 #if JSON_HAS_RVALUE_REFERENCES
-    CZString(CZString&& other);
+    CZString(CZString&& other) JSONCPP_NOEXCEPT;
 #endif
     ~CZString();
     CZString& operator=(CZString other);
@@ -258,11 +468,9 @@ private:
   };
 
 public:
-#ifndef JSON_USE_CPPTL_SMALLMAP
-  typedef std::map<CZString, Value> ObjectValues;
-#else
-  typedef CppTL::SmallMap<CZString, Value> ObjectValues;
-#endif // ifndef JSON_USE_CPPTL_SMALLMAP
+  class SharedPayload;
+  class ObjectValues;
+  class ArrayValues;
 #endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
 
 public:
@@ -312,11 +520,16 @@ Json::Value obj_value(Json::objectValue); // {}
   Value(const CppTL::ConstString& value);
 #endif
   Value(bool value);
+  /** \brief Create a Value of the given type whose storage, and that of
+   * everything later stored into it, is in arena. A CharReader parsing into
+   * it builds the document there.
+   */
+  explicit Value(Arena& arena, ValueType type = nullValue);
   /// Deep copy.
   Value(const Value& other);
 #if JSON_HAS_RVALUE_REFERENCES
   /// Move constructor
-  Value(Value&& other);
+  Value(Value&& other) JSONCPP_NOEXCEPT;
 #endif
   ~Value();
 
@@ -329,6 +542,9 @@ Json::Value obj_value(Json::objectValue); // {}
   void swapPayload(Value& other);
 
   ValueType type() const;
+  /// \return the arena of this value, made with Value(Arena&, ValueType) or
+  /// stored in an array or object of that value, or NULL.
+  Arena* arena() const;
 
   /// Compare payload only, not comments etc.
   bool operator<(const Value& other) const;
@@ -339,7 +555,57 @@ Json::Value obj_value(Json::objectValue); // {}
   bool operator!=(const Value& other) const;
   int compare(const Value& other) const;
 
-  const char* asCString() const; ///< Embedded zeroes could cause you trouble!
+  /// \brief Hash of the structure and contents of this value, consistent with
+  /// operator==(): equal values have equal hashes.
+  ///
+  /// The hash of an array or object is remembered by its payload, and so
+  /// shared by its copies, until it is modified; operator==() then tells
+  /// most unequal containers apart by their hashes alone. Containers pinned
+  /// by a mutable reference (see the class documentation) are hashed anew
+  /// each time.
+  size_t hash() const;
+
+  /// Bytes taken by a value and everything under it, by what they hold.
+  struct MemoryUsage {
+    MemoryUsage();
+    /// The Values themselves, and the records of their comments and
+    /// offsets.
+    size_t nodes;
+    /// Storage of arrays and objects beyond their Values: spare capacity,
+    /// tree nodes, hash indexes, packed numbers.
+    size_t containers;
+    /// Member names: one CZString per member, and the characters of the
+    /// names the objects own. Names of the KeyPool, or static, cost
+    /// nothing more.
+    size_t keys;
+    /// Characters of strings not held inside their Value, and the source
+    /// text of numbers, with their headers.
+    size_t strings;
+    /// Characters of comments.
+    size_t comments;
+
+    size_t total() const;
+    MemoryUsage& operator+=(const MemoryUsage& other);
+  };
+  /** \brief Count the bytes taken by this value and everything under it,
+   * this Value included.
+   *
+   * Storage shared by several copies, as arrays, objects, strings and
+   * shapes are, is counted once per call however many values of the tree
+   * refer to it. Values of an arena are counted as others, though their
+   * bytes are the arena's (see Arena::bytesUsed()).
+   *
+   * \param approximate If true, only some elements of large arrays and
+   *        objects are measured, and the result scaled: this takes a
+   *        bounded time per array or object, and does not tell shared
+   *        storage apart.
+   */
+  MemoryUsage memoryUsage(bool approximate = false) const;
+
+  /// Embedded zeroes could cause you trouble!
+  /// \note Short strings are stored inside the Value itself, so the pointer
+  ///  is only valid as long as this Value is neither destroyed nor moved.
+  const char* asCString() const;
 #if JSONCPP_USING_SECURE_MEMORY
   unsigned getCStringLength() const; //Allows you to understand the length of the CString
 #endif
@@ -349,6 +615,26 @@ Json::Value obj_value(Json::objectValue); // {}
    */
   bool getString(
       char const** begin, char const** end) const;
+  /** Get the source text of a real number read with the "lazyNumbers"
+   *  setting of CharReaderBuilder. Writers output it as is.
+   *  \return false if this value holds no such text.
+   */
+  bool getNumberText(char const** begin, char const** end) const;
+  /** Get the escaped source text, without quotes, of a string read with the
+   *  "lazyStrings" setting of CharReaderBuilder. Writers output it as is.
+   *  \return false if this value holds no such text, or if it is not the
+   *  text writers would output for the string: it holds control characters,
+   *  or escapes that writers do not make, such as "\u00e9" or "\/".
+   */
+  bool getRawString(char const** begin, char const** end) const;
+  /** Get the elements of an array of real numbers read with the
+   *  "packNumbers" setting of CharReaderBuilder, stored contiguously
+   *  without a Value each. Valid until the array is modified.
+   *  \return false if this value holds no such elements.
+   */
+  bool getPackedReals(double const** begin, double const** end) const;
+  /// Same as getPackedReals(), for an array of intValues.
+  bool getPackedInts(LargestInt const** begin, LargestInt const** end) const;
 #ifdef JSON_USE_CPPTL
   CppTL::ConstString asConstString() const;
 #endif
@@ -394,6 +680,12 @@ Json::Value obj_value(Json::objectValue); // {}
   /// \post type() is unchanged
   void clear();
 
+  /// Remove all object members and array elements, but keep the storage
+  /// they used (vector capacity, hash index) for the next ones. Any other
+  /// value becomes null. Comments are kept.
+  /// \post type() is unchanged, or nullValue if it was not an array or object
+  void reset();
+
   /// Resize the array to size elements.
   /// New elements are initialized to null.
   /// May only be called on nullValue or arrayValue.
@@ -401,6 +693,16 @@ Json::Value obj_value(Json::objectValue); // {}
   /// \post type() is arrayValue
   void resize(ArrayIndex size);
 
+  /// Make room for size elements of an array, or members of an object, so
+  /// that adding them does not grow the storage step by step.
+  /// size() is unchanged.
+  /// \pre type() is arrayValue, objectValue, or nullValue
+  /// \post type() is unchanged, or arrayValue if it was nullValue
+  void reserve(ArrayIndex size);
+  /// Release the room reserved beyond the current elements or members.
+  /// \pre type() is arrayValue, objectValue, or nullValue
+  void shrinkToFit();
+
   /// Access an array element (zero based index ).
   /// If the array contains less than index element, then null value are
   /// inserted
@@ -435,8 +737,23 @@ Json::Value obj_value(Json::objectValue); // {}
   bool isValidIndex(ArrayIndex index) const;
   /// \brief Append value to array at the end.
   ///
-  /// Equivalent to jsonvalue[jsonvalue.size()] = value;
+  /// Equivalent to jsonvalue[jsonvalue.size()] = value, in amortized
+  /// constant time.
+  /// \note Like any growth of the array, this may invalidate references to
+  ///  the other elements.
   Value& append(const Value& value);
+#if JSON_HAS_RVALUE_REFERENCES
+  /// \brief Append value to array at the end, moving it rather than copying.
+  Value& append(Value&& value);
+  /// \brief Append a value constructed in place from args.
+  ///
+  /// \code
+  /// Json::Value list;
+  /// list.emplace_back("text");
+  /// list.emplace_back(Json::objectValue);
+  /// \endcode
+  template <typename... Args> Value& emplace_back(Args&&... args);
+#endif
 
   /// Access an object value by name, create a null member if it does not exist.
   /// \note Because of our implementation, keys are limited to 2^30 -1 chars.
@@ -465,6 +782,18 @@ Json::Value obj_value(Json::objectValue); // {}
    * \endcode
    */
   Value& operator[](const StaticString& key);
+#if JSON_HAS_RVALUE_REFERENCES
+  /// \brief Set the member named key to value, adding it if it does not exist.
+  ///
+  /// value is moved into the object rather than copied, and a new name is
+  /// copied once. Returns the member.
+  /// \param key may contain embedded nulls.
+  Value& insert(const char* begin, const char* end, Value&& value);
+  Value& insert(const JSONCPP_STRING& key, Value&& value);
+  /// As above, but the name of a new member is not duplicated (see
+  /// operator[](const StaticString&)).
+  Value& insert(const StaticString& key, Value&& value);
+#endif
 #ifdef JSON_USE_CPPTL
   /// Access an object value by name, create a null member if it does not exist.
   Value& operator[](const CppTL::ConstString& key);
@@ -527,6 +856,37 @@ Json::Value obj_value(Json::objectValue); // {}
       \return true iff removed (no exceptions)
   */
   bool removeIndex(ArrayIndex i, Value* removed);
+  /** \brief Remove the array elements for which pred(element) is true.
+
+      The elements kept are moved down in one pass, in order.
+      \return the number of elements removed; 0 unless type() is arrayValue.
+      \code
+      list.eraseIf([](Json::Value const& v) { return v.isNull(); });
+      \endcode
+  */
+  template <typename Predicate> ArrayIndex eraseIf(Predicate pred);
+  /** \brief Remove the array elements [first, last).
+
+      \return true iff removed, i.e. type() is arrayValue and
+      first <= last <= size() (no exceptions)
+  */
+  bool erase(ArrayIndex first, ArrayIndex last);
+  /** \brief Insert value before the element at index, moving the later ones
+      up. index may be size(), to append.
+
+      \pre type() is arrayValue or nullValue
+      \return true iff inserted, i.e. index <= size()
+  */
+  bool insert(ArrayIndex index, const Value& value);
+#if JSON_HAS_RVALUE_REFERENCES
+  /// Same as insert(ArrayIndex, const Value&), moving value rather than
+  /// copying it.
+  bool insert(ArrayIndex index, Value&& value);
+#endif
+  /// Remove the elements from index size on. Unlike resize(), never grows
+  /// the array.
+  /// \pre type() is arrayValue or nullValue
+  void truncate(ArrayIndex size);
 
   /// Return true if the object has a member named key.
   /// \note 'key' must be null-terminated.
@@ -541,6 +901,16 @@ Json::Value obj_value(Json::objectValue); // {}
   bool isMember(const CppTL::ConstString& key) const;
 #endif
 
+  // Same as the overloads taking a name, without computing its length and
+  // hash again (see Key).
+  Value& operator[](const Key& key);
+  const Value& operator[](const Key& key) const;
+  Value const* find(const Key& key) const;
+  Value get(const Key& key, const Value& defaultValue) const;
+  bool isMember(const Key& key) const;
+  Value removeMember(const Key& key);
+  bool removeMember(const Key& key, Value* removed);
+
   /// \brief Return a list of the member names.
   ///
   /// If null, return an empty list.
@@ -548,6 +918,39 @@ Json::Value obj_value(Json::objectValue); // {}
   /// \post if type() was nullValue, it remains nullValue
   Members getMemberNames() const;
 
+  /// \brief Call visit(name, length, value) for each member, in name order.
+  ///
+  /// Unlike getMemberNames(), this neither copies the names nor looks the
+  /// members up again: name points into the object, null-terminated, and
+  /// may contain embedded nulls. Does nothing unless type() is objectValue.
+  /// \code
+  /// object.forEachMember(
+  ///     [&](char const* name, unsigned length, Json::Value const& value) {
+  ///       out.append(name, length).append(value.asString());
+  ///     });
+  /// \endcode
+  template <typename Visitor> void forEachMember(Visitor visit) const;
+
+  /// \brief Apply an RFC 7396 merge patch to this value, in place.
+  ///
+  /// If patch is an object, its null members remove the members of the
+  /// same names, and its other members are merged into the members of the
+  /// same names, recursively; this value becomes an object first if it is
+  /// not one. Any other patch replaces this value. Only the members the
+  /// patch names are visited.
+  /// \pre patch is neither this value nor part of it.
+  /// \code
+  /// Json::Value config = defaults;
+  /// config.mergePatch(environment);
+  /// config.mergePatch(std::move(tenantOverrides));
+  /// \endcode
+  void mergePatch(const Value& patch);
+#if JSON_HAS_RVALUE_REFERENCES
+  /// Same as mergePatch(const Value&), taking the subtrees of patch rather
+  /// than copying them. patch is left null.
+  void mergePatch(Value&& patch);
+#endif
+
   //# ifdef JSON_USE_CPPTL
   //      EnumMemberNames enumMemberNames() const;
   //      EnumValues enumValues() const;
@@ -573,17 +976,103 @@ Json::Value obj_value(Json::objectValue); // {}
   iterator end();
 
   // Accessors for the [start, limit) range of bytes within the JSON text from
-  // which this value was parsed, if any.
+  // which this value was parsed, if any. (See the "collectOffsets" setting of
+  // CharReaderBuilder.)
   void setOffsetStart(ptrdiff_t start);
   void setOffsetLimit(ptrdiff_t limit);
   ptrdiff_t getOffsetStart() const;
   ptrdiff_t getOffsetLimit() const;
 
 private:
+  /// Create a Value of the given type whose array or object is in arena, if
+  /// not NULL. Unlike Value(Arena&, ValueType), what is later stored into
+  /// the value itself is not copied there.
+  Value(ValueType type, Arena* arena);
   void initBasic(ValueType type, bool allocated = false);
+  /// Store a copy of the string, inline if it is short enough, in arena if
+  /// not NULL.
+  void initString(const char* str, unsigned length, Arena* arena = 0);
+  /// \return false if this stringValue holds no string at all.
+  bool decodeString(unsigned* length, char const** str) const;
+  /// Keep the source text of a realValue, to be decoded when first used.
+  void initNumberText(const char* begin, const char* end, Arena* arena = 0);
+  /// \return the value of a realValue, decoding its text if need be.
+  double decodedReal() const;
+  /// Keep the source text of a stringValue, to be unescaped when first used.
+  /// Only text without escapes may be kept in an arena. verbatim tells
+  /// whether writers would output the same text for the string.
+  void initRawString(const char* begin, const char* end, bool escaped,
+                     bool verbatim, Arena* arena = 0);
+
+  friend class Arena;
+  template <typename T> friend class ArenaAllocator;
+  friend void deferredRelease(Value&& value);
+  friend class FrozenNode;
+  /// Make a value constructed in the storage of an arena part of it: move
+  /// its payload there.
+  static void settle(Value& value, Arena& arena);
+  template <typename Name>
+  static void settle(std::pair<Name, Value>& member, Arena& arena) {
+    settle(member.second, arena);
+  }
+  template <typename Other> static void settle(Other&, Arena&) {}
+  /// Copy the payload of a value of an arena there, if it is elsewhere.
+  void adoptPayload();
+
+  struct Extra;
+  /// \return the comments and offsets of this value, or NULL if none.
+  Extra* getExtra() const;
+  Extra& demandExtra();
 
   Value& resolveReference(const char* key);
   Value& resolveReference(const char* key, const char* end);
+  Value& placeMember(const char* key, const char* end, Value& value,
+                     bool overwrite);
+  /// Convert a null value to an empty array, and return its elements ready
+  /// to be appended to.
+  ArrayValues& demandArray();
+
+  /// Give this array or object a payload of its own, copying it if it is
+  /// shared.
+  void detach();
+  /// detach(), and mark the payload as unshareable: a mutable reference to
+  /// one of its elements is about to be handed out.
+  void pin();
+  /// Mark the payload as shareable again, once the references handed out
+  /// since pin() are no longer used. (The reader does so for the arrays and
+  /// objects it builds.)
+  void unpin();
+  friend class OurReader;
+  // Reading a document over the one this value holds (the "reuseValues"
+  // setting of CharReaderBuilder):
+  /// Pin an array or object, and mark its elements or members as stale.
+  void startReuse();
+  /// \return the element at index, or the member named [key, cend), if it
+  /// is still stale, without that mark or comments; NULL otherwise.
+  Value* reuseElement(ArrayIndex index);
+  Value* reuseMember(const char* key, const char* cend);
+  /// Remove the elements or members still stale.
+  void finishReuse();
+  /// Set this value to a copy of the string, in its current buffer if it
+  /// has one of its own that is long enough, or else in arena if not NULL.
+  void reuseString(const char* str, unsigned length, Arena* arena);
+  /// Hold the elements of this array unboxed if they are all intValues, or
+  /// all realValues without source text, and none has comments or source
+  /// offsets (the "packNumbers" setting).
+  void packNumbers();
+  /// The member names of objects of the same "shape", shared by them (the
+  /// "shareShapes" setting).
+  struct Shape;
+  /// Share the member names of this object with the last objects read at
+  /// the same depth, whose shape is last, if they are the same. A new shape
+  /// is only made for names met twice in a row: candidate is the hash of
+  /// the names of the last object left as is.
+  void shareShape(Shape*& last, UInt& candidate);
+  static void releaseShape(Shape* shape);
+  /// State of memoryUsage() along the tree.
+  struct UsageWalk;
+  void addMemoryUsage(UsageWalk& walk) const;
+  static bool knownToDiffer(const SharedPayload& a, const SharedPayload& b);
 
   struct CommentInfo {
     CommentInfo();
@@ -609,19 +1098,329 @@ private:
     double real_;
     bool bool_;
     char* string_;  // actually ptr to unsigned, followed by str, unless !allocated_
+    char inline_[sizeof(LargestUInt)]; // null-terminated, iff inlined_
     ObjectValues* map_;
+    ArrayValues* array_;
   } value_;
   ValueType type_ : 8;
   unsigned int allocated_ : 1; // Notes: if declared as bool, bitfield is useless.
                                // If not allocated_, string_ must be null-terminated.
-  CommentInfo* comments_;
+                               // A realValue that is allocated_ holds its
+                               // source text in string_ instead of real_.
+  unsigned int inlined_ : 1;   // Short strings are kept in value_.inline_
+  unsigned int inlineLength_ : 3;
+  unsigned int raw_ : 1;       // string_ holds the escaped source text of a
+                               // string, unescaped when first used
+  unsigned int stale_ : 1;     // Element or member not read again yet, see
+                               // startReuse(). Moved, not copied.
+  unsigned int arenaId_ : 12;  // Arena::id() of the arena of this value, or
+                               // 0. Neither moved nor copied.
+  // Handle of the comments and source offsets of this value in the side
+  // table, or 0 if it has none.
+  UInt extra_;
+};
+
+#ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
+/** \brief Reference count of an array or object payload, shared by the
+ * copies of the Values that hold it.
+ *
+ * A payload that is not shareable is copied instead (see Value::pin()).
+ */
+class JSON_API Value::SharedPayload {
+public:
+  explicit SharedPayload(Arena* arena = 0)
+      : refs_(1), shareable_(true), digest_(0), arena_(arena) {}
+  // A copy of a payload is a new payload, on the heap.
+  SharedPayload(const SharedPayload&)
+      : refs_(1), shareable_(true), digest_(0), arena_(0) {}
+  SharedPayload& operator=(const SharedPayload&) { return *this; }
+
+  std::atomic<unsigned> refs_;
+  bool shareable_;
+  /// Value::hash() of the payload, or 0 if not known. Only a shareable
+  /// payload remembers it; any change forgets it.
+  mutable std::atomic<size_t> digest_;
+  /// Arena holding the payload and its elements, or NULL. Such a payload is
+  /// never shared, nor freed: copies of it are made on the heap.
+  Arena* arena_;
+};
+
+/** \brief Allocator of the storage of arrays and objects, from their arena
+ * if they have one, or else from the heap.
+ *
+ * Values constructed in storage of an arena become part of it (see
+ * Arena). Copies of containers are made on the heap.
+ */
+template <typename T> class ArenaAllocator {
+public:
+  typedef T value_type;
+  typedef std::false_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  ArenaAllocator() : arena_(0) {}
+  explicit ArenaAllocator(Arena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  T* allocate(size_t count) {
+    size_t size = count * sizeof(T);
+    return static_cast<T*>(arena_ ? arena_->allocate(size)
+                                  : ::operator new(size));
+  }
+  void deallocate(T* block, size_t) {
+    if (!arena_)
+      ::operator delete(block);
+  }
+  template <typename U, typename... Args>
+  void construct(U* place, Args&&... args) {
+    ::new (static_cast<void*>(place)) U(std::forward<Args>(args)...);
+    if (arena_)
+      Value::settle(*place, *arena_);
+  }
+  template <typename U> void destroy(U* place) { place->~U(); }
+  ArenaAllocator select_on_container_copy_construction() const {
+    return ArenaAllocator();
+  }
+
+  Arena* arena() const { return arena_; }
+  template <typename U> bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena();
+  }
+  template <typename U> bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena();
+  }
+
+private:
+  Arena* arena_;
+};
+
+/// Elements of an #arrayValue.
+class JSON_API Value::ArrayValues
+    : public std::vector<Value, ArenaAllocator<Value> >,
+      public SharedPayload {
+public:
+  explicit ArrayValues(Arena* arena = 0)
+      : std::vector<Value, ArenaAllocator<Value> >(
+            ArenaAllocator<Value>(arena)),
+        SharedPayload(arena), packed_(0), boxed_(false) {}
+  ArrayValues(const ArrayValues& other);
+  ~ArrayValues();
+
+  /// Numbers of one type held unboxed (see Value::getPackedReals()), or
+  /// NULL. The vector is then empty, until the elements are first needed
+  /// as Values: boxed() then copies them there, and keeps both, as other
+  /// threads may be reading the packed numbers.
+  struct Packed;
+  Packed* packed_;
+
+  /// \return the number of elements, packed or not.
+  ArrayIndex count() const;
+  /// \return the elements as Values, boxing packed numbers the first time.
+  /// Safe to call from several threads at once, as const methods are.
+  const ArrayValues& boxed() const;
+  /// Compare the elements, packed or not, as operator== on Values would.
+  bool sameElements(const ArrayValues& other) const;
+  /// Box packed numbers if need be, and drop them: the vector is about to
+  /// change.
+  void unpack();
+  /// Drop the packed numbers, as the vector is being cleared.
+  void dropPacked();
+
+private:
+  ArrayValues& operator=(const ArrayValues&); // not implemented
 
-  // [start, limit) byte offsets in the source JSON text from which this Value
-  // was extracted.
-  ptrdiff_t start_;
-  ptrdiff_t limit_;
+  mutable std::atomic<bool> boxed_; // whether the vector holds packed_ too
 };
 
+/** \brief Members of an #objectValue, sorted by name.
+ *
+ * Most objects are small, so members are kept in a flat vector sorted by
+ * name, which costs a single allocation and is searched in place. An object
+ * that grows beyond #smallObjectLimit members is promoted to a tree, and
+ * stays one until it is cleared. Once it reaches #hashIndexThreshold
+ * members, the tree is also indexed by a hash of the member names, so that
+ * lookups no longer walk a chain of string comparisons. Iteration is always
+ * in name order.
+ *
+ * \note As with std::vector, inserting or erasing a member of a flat object
+ * invalidates references and iterators to the other members.
+ */
+class JSON_API Value::ObjectValues : public SharedPayload {
+  typedef std::pair<CZString, Value> Member;
+  typedef std::vector<Member, ArenaAllocator<Member> > Flat;
+  typedef std::map<CZString, Value, std::less<CZString>,
+                   ArenaAllocator<std::pair<const CZString, Value> > >
+      Tree;
+
+public:
+  /// Objects with more members than this are stored in a tree.
+  static const size_t smallObjectLimit = 16;
+  /// Objects with at least this many members get a hash index.
+  static const size_t hashIndexThreshold = 64;
+
+  class iterator {
+  public:
+    iterator() : member_(0), node_(), flat_(true), name_(0), value_(0) {}
+
+    const CZString& key() const {
+      return name_ ? *name_ : flat_ ? member_->first : node_->first;
+    }
+    Value& value() const {
+      return name_ ? *value_ : flat_ ? member_->second : node_->second;
+    }
+
+    iterator& operator++() {
+      if (name_) {
+        ++name_;
+        ++value_;
+      } else if (flat_) {
+        ++member_;
+      } else {
+        ++node_;
+      }
+      return *this;
+    }
+    iterator& operator--() {
+      if (name_) {
+        --name_;
+        --value_;
+      } else if (flat_) {
+        --member_;
+      } else {
+        --node_;
+      }
+      return *this;
+    }
+    bool operator==(const iterator& other) const {
+      if (name_)
+        return value_ == other.value_;
+      return flat_ ? member_ == other.member_ : node_ == other.node_;
+    }
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+
+  private:
+    friend class ObjectValues;
+    explicit iterator(Member* member)
+        : member_(member), node_(), flat_(true), name_(0), value_(0) {}
+    explicit iterator(const Tree::iterator& node)
+        : member_(0), node_(node), flat_(false), name_(0), value_(0) {}
+    iterator(const CZString* name, Value* value)
+        : member_(0), node_(), flat_(true), name_(name), value_(value) {}
+
+    Member* member_;
+    Tree::iterator node_;
+    bool flat_;
+    // Name and value of a member of a shaped object; NULL otherwise.
+    const CZString* name_;
+    Value* value_;
+  };
+
+  explicit ObjectValues(Arena* arena = 0);
+  ObjectValues(const ObjectValues& other);
+  ~ObjectValues();
+
+  size_t size() const;
+  bool empty() const;
+  /// Remove all members, and go back to the flat representation.
+  void clear();
+  /// Remove all members, keeping the current representation and its storage.
+  void reset();
+
+  iterator begin();
+  iterator end();
+  iterator find(const CZString& key);
+  /// Same as find(key), given the hashKey() of its name.
+  iterator find(const CZString& key, UInt hash);
+  /// Return the member named key, inserting a null member if it does not
+  /// exist. The key is copied according to its duplication policy.
+  Value& resolve(const CZString& key);
+  /// Make room for count members. An object that will not fit the flat
+  /// representation is promoted (and indexed) right away.
+  void reserve(size_t count);
+  void shrinkToFit();
+  /// Set the member named key to value, inserting it if it does not exist.
+  /// The payload of value is taken.
+  Value& assign(const CZString& key, Value& value);
+  /// \return the member following it.
+  iterator erase(iterator it);
+
+  /// Compare sizes, then members in order.
+  bool operator==(const ObjectValues& other) const;
+  /// Lexicographical comparison of the (name, value) sequences.
+  bool operator<(const ObjectValues& other) const;
+
+  /// Hold the names of the members in a Shape: last, if it has the same
+  /// names. Otherwise, if the names hash to candidate, the object before
+  /// had the same: hold them in a new Shape, which replaces last. Else
+  /// stay as is, and make the hash of the names the candidate. An object
+  /// already shaped keeps its shape, which replaces last.
+  /// \pre The object is not empty, nor in an arena.
+  void share(Shape*& last, UInt& candidate);
+  /// Count the storage of the members and their names, not the Values of
+  /// the members.
+  void addUsage(UsageWalk& walk) const;
+
+private:
+  ObjectValues& operator=(const ObjectValues&); // not implemented
+
+  void promote();
+  /// Give the members their names back, and drop the shape.
+  void unshape();
+  void dropShape();
+  Value& place(const CZString& key, Value& value, bool overwrite);
+  /// \return the name to store for a new member named key.
+  CZString storedKey(const CZString& key) const;
+
+  struct Index;
+
+  Flat flat_;
+  Tree* tree_;
+  Index* index_;
+  // Names of the members in order, shared with objects of the same shape,
+  // and their values; flat_ is then empty. Any change to the names puts
+  // them back in the members.
+  Shape* shape_;
+  Value* values_;
+};
+
+template <typename Visitor> void Value::forEachMember(Visitor visit) const {
+  if (type_ != objectValue)
+    return;
+  ObjectValues::iterator end = value_.map_->end();
+  for (ObjectValues::iterator it = value_.map_->begin(); it != end; ++it) {
+    const CZString& name = it.key();
+    visit(name.data(), name.length(), static_cast<const Value&>(it.value()));
+  }
+}
+
+template <typename Predicate> ArrayIndex Value::eraseIf(Predicate pred) {
+  if (type_ != arrayValue)
+    return 0;
+  detach();
+  ArrayValues& array = *value_.array_;
+  ArrayValues::iterator kept = array.begin();
+  for (ArrayValues::iterator it = kept; it != array.end(); ++it) {
+    if (pred(static_cast<const Value&>(*it)))
+      continue;
+    if (kept != it)
+      kept->swap(*it);
+    ++kept;
+  }
+  ArrayIndex removed = ArrayIndex(array.end() - kept);
+  array.erase(kept, array.end());
+  return removed;
+}
+
+#if JSON_HAS_RVALUE_REFERENCES
+template <typename... Args> Value& Value::emplace_back(Args&&... args) {
+  ArrayValues& array = demandArray();
+  array.emplace_back(std::forward<Args>(args)...);
+  return array.back();
+}
+#endif
+#endif // ifndef JSONCPP_DOC_EXCLUDE_IMPLEMENTATION
+
 /** \brief Experimental and untested: represents an element of the "path" to
  * access a node.
  */
@@ -740,6 +1539,10 @@ protected:
 
 private:
   Value::ObjectValues::iterator current_;
+  // Elements of an array are addressed by position, so that the iterator
+  // does not depend on where the vector keeps them. Null if not an array.
+  Value::ArrayValues* array_;
+  ArrayIndex index_;
   // Indicates that iterator is for a null value.
   bool isNull_;
 
@@ -748,6 +1551,7 @@ public:
   // than earlier. No idea why.
   ValueIteratorBase();
   explicit ValueIteratorBase(const Value::ObjectValues::iterator& current);
+  ValueIteratorBase(Value::ArrayValues* array, ArrayIndex index);
 };
 
 /** \brief const iterator for object and array value.
@@ -771,6 +1575,7 @@ private:
 /*! \internal Use by Value to create an iterator.
  */
   explicit ValueConstIterator(const Value::ObjectValues::iterator& current);
+  ValueConstIterator(Value::ArrayValues* array, ArrayIndex index);
 public:
   SelfType& operator=(const ValueIteratorBase& other);
 
@@ -822,6 +1627,7 @@ private:
 /*! \internal Use by Value to create an iterator.
  */
   explicit ValueIterator(const Value::ObjectValues::iterator& current);
+  ValueIterator(Value::ArrayValues* array, ArrayIndex index);
 public:
   SelfType& operator=(const SelfType& other);
 
@@ -859,6 +1665,12 @@ namespace std {
 /// Specialize std::swap() for Json::Value.
 template<>
 inline void swap(Json::Value& a, Json::Value& b) { a.swap(b); }
+
+/// Specialize std::hash for Json::Value, so that it can key hash containers.
+template<>
+struct hash<Json::Value> {
+  size_t operator()(const Json::Value& value) const { return value.hash(); }
+};
 }
 
 #pragma pack(pop)
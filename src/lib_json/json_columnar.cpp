@@ -0,0 +1,398 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include <json/assertions.h>
+#include <json/columnar.h>
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#if defined(JSON_HAS_INT64)
+
+namespace Json {
+
+// The records are walked twice: once to find the members and the kinds of
+// values each holds, which decide the type of its column, then once to fill
+// the columns kept.
+
+namespace {
+// Kinds of values met at a path.
+enum {
+  boolKind = 1 << 0,
+  intKind = 1 << 1,      // in the range of Int64
+  negativeKind = 1 << 2, // an intKind below 0
+  bigKind = 1 << 3,      // a UInt64 beyond Int64
+  realKind = 1 << 4,
+  stringKind = 1 << 5,
+  arrayKind = 1 << 6,
+  objectKind = 1 << 7
+};
+
+const unsigned numberKinds = intKind | negativeKind | bigKind | realKind;
+
+unsigned kindOf(const Value& value) {
+  switch (value.type()) {
+  case booleanValue:
+    return boolKind;
+  case intValue:
+    return value.asInt64() < 0 ? intKind | negativeKind : intKind;
+  case uintValue:
+    return value.isInt64() ? intKind : bigKind;
+  case realValue:
+    return realKind;
+  case stringValue:
+    return stringKind;
+  case arrayValue:
+    return arrayKind;
+  case objectValue:
+    return objectKind;
+  default:
+    return 0;
+  }
+}
+
+// \return the type of the column of a path holding kinds, or -1 if the path
+// makes none.
+int columnType(unsigned kinds) {
+  unsigned scalars = kinds & ~unsigned(objectKind);
+  if (kinds & arrayKind)
+    return -1;
+  if (!scalars)
+    return kinds ? -1 : nullValue; // only objects, or only nulls
+  if (kinds & objectKind)
+    return -1;
+  if (scalars == boolKind)
+    return booleanValue;
+  if (scalars == stringKind)
+    return stringValue;
+  if (scalars & ~numberKinds)
+    return -1;
+  if ((scalars & realKind) || (scalars & (negativeKind | bigKind)) ==
+                                  (negativeKind | bigKind))
+    return realValue;
+  return (scalars & bigKind) ? uintValue : intValue;
+}
+
+// Append the name of a member to the path of its object. A '.' or '\\' in
+// the name is escaped with '\\', so that a member named "a.b" does not
+// collide with member "b" of member "a".
+void appendName(JSONCPP_STRING& path, char const* name, unsigned length) {
+  if (!path.empty())
+    path += '.';
+  char const* end = name + length;
+  for (char const* c = name; c != end; ++c) {
+    if (*c == '.' || *c == '\\')
+      path += '\\';
+    path += *c;
+  }
+}
+} // namespace
+
+struct ColumnarView::Builder {
+  explicit Builder(ColumnarView& view) : view_(view) {}
+
+  void survey(const Value& record);
+  void makeColumns();
+  void fill(const Value& record, ArrayIndex row);
+  void endRow(ArrayIndex row);
+
+  ColumnarView& view_;
+  // Every path met, in that order, with the kinds of its values.
+  std::vector<JSONCPP_STRING> paths_;
+  std::vector<unsigned> kinds_;
+  std::unordered_map<JSONCPP_STRING, size_t> pathIndex_;
+  // Column of each path, or NULL if it makes none.
+  std::vector<Column*> columns_;
+  std::vector<Column*> stringColumns_;
+  // Path of the member being visited.
+  JSONCPP_STRING path_;
+};
+
+void ColumnarView::Builder::survey(const Value& record) {
+  record.forEachMember([this](char const* name, unsigned length,
+                              const Value& member) {
+    size_t parent = path_.size();
+    appendName(path_, name, length);
+    std::unordered_map<JSONCPP_STRING, size_t>::iterator it =
+        pathIndex_.find(path_);
+    if (it == pathIndex_.end()) {
+      it = pathIndex_.insert(std::make_pair(path_, paths_.size())).first;
+      paths_.push_back(path_);
+      kinds_.push_back(0);
+    }
+    kinds_[it->second] |= kindOf(member);
+    if (member.isObject())
+      survey(member);
+    path_.resize(parent);
+  });
+}
+
+void ColumnarView::Builder::makeColumns() {
+  columns_.resize(paths_.size());
+  for (size_t i = 0; i < paths_.size(); ++i) {
+    int type = columnType(kinds_[i]);
+    if (type < 0)
+      continue;
+    Column* column =
+        new Column(paths_[i], static_cast<ValueType>(type), view_.rows_);
+    view_.columns_.push_back(column);
+    columns_[i] = column;
+    if (type == stringValue)
+      stringColumns_.push_back(column);
+  }
+}
+
+void ColumnarView::Builder::fill(const Value& record, ArrayIndex row) {
+  record.forEachMember([this, row](char const* name, unsigned length,
+                                   const Value& member) {
+    size_t parent = path_.size();
+    appendName(path_, name, length);
+    Column* column = columns_[pathIndex_.find(path_)->second];
+    if (member.isObject()) {
+      fill(member, row);
+    } else if (column && !member.isNull()) {
+      column->validity_[row / 64] |= UInt64(1) << (row % 64);
+      switch (column->type_) {
+      case booleanValue:
+        column->bools_[row] = member.asBool();
+        break;
+      case intValue:
+        column->ints_[row] = member.asInt64();
+        break;
+      case uintValue:
+        column->uints_[row] = member.asUInt64();
+        break;
+      case realValue:
+        column->reals_[row] = member.asDouble();
+        break;
+      case stringValue: {
+        char const* begin;
+        char const* end;
+        member.getString(&begin, &end);
+        column->chars_.insert(column->chars_.end(), begin, end);
+      } break;
+      default:
+        break;
+      }
+    }
+    path_.resize(parent);
+  });
+}
+
+// Strings are appended row after row: close the one of row in each column.
+void ColumnarView::Builder::endRow(ArrayIndex row) {
+  for (size_t i = 0; i < stringColumns_.size(); ++i)
+    stringColumns_[i]->offsets_[row + 1] = stringColumns_[i]->chars_.size();
+}
+
+// class ColumnarView
+// //////////////////////////////////////////////////////////////////
+
+ColumnarView::ColumnarView() : rows_(0) {}
+
+ColumnarView::ColumnarView(const Value& records) : rows_(0) {
+  JSON_ASSERT_MESSAGE(
+      records.type() == nullValue || records.type() == arrayValue,
+      "in Json::ColumnarView::ColumnarView(): requires arrayValue");
+  rows_ = records.size();
+  Builder builder(*this);
+  for (ArrayIndex row = 0; row < rows_; ++row)
+    builder.survey(records[row]);
+  try {
+    builder.makeColumns();
+    for (ArrayIndex row = 0; row < rows_; ++row) {
+      builder.fill(records[row], row);
+      builder.endRow(row);
+    }
+  } catch (...) {
+    for (size_t i = 0; i < columns_.size(); ++i)
+      delete columns_[i];
+    throw;
+  }
+}
+
+ColumnarView::ColumnarView(const ColumnarView& other) : rows_(other.rows_) {
+  columns_.reserve(other.columns_.size());
+  try {
+    for (size_t i = 0; i < other.columns_.size(); ++i)
+      columns_.push_back(new Column(*other.columns_[i]));
+  } catch (...) {
+    for (size_t i = 0; i < columns_.size(); ++i)
+      delete columns_[i];
+    throw;
+  }
+}
+
+#if JSON_HAS_RVALUE_REFERENCES
+ColumnarView::ColumnarView(ColumnarView&& other) : rows_(0) { swap(other); }
+#endif
+
+ColumnarView::~ColumnarView() {
+  for (size_t i = 0; i < columns_.size(); ++i)
+    delete columns_[i];
+}
+
+ColumnarView& ColumnarView::operator=(ColumnarView other) {
+  swap(other);
+  return *this;
+}
+
+void ColumnarView::swap(ColumnarView& other) {
+  std::swap(rows_, other.rows_);
+  columns_.swap(other.columns_);
+}
+
+bool ColumnarView::parse(const CharReaderBuilder& builder, char const* begin,
+                         char const* end, ColumnarView* view,
+                         JSONCPP_STRING* errs) {
+  // As for FrozenValue::parse(), the document only lives in an arena, until
+  // its columns are made.
+  Arena arena(std::max<size_t>(64 * 1024, static_cast<size_t>(end - begin)));
+  Value document(arena);
+  std::unique_ptr<CharReader> const reader(builder.newCharReader());
+  if (!reader->parse(begin, end, &document, errs))
+    return false;
+  if (!document.isNull() && !document.isArray()) {
+    if (errs)
+      *errs = "The document is not an array of records";
+    return false;
+  }
+  ColumnarView(document).swap(*view);
+  return true;
+}
+
+ArrayIndex ColumnarView::rows() const { return rows_; }
+
+ArrayIndex ColumnarView::columns() const {
+  return ArrayIndex(columns_.size());
+}
+
+const ColumnarView::Column& ColumnarView::operator[](ArrayIndex index) const {
+  JSON_ASSERT_MESSAGE(index < columns_.size(),
+                      "in Json::ColumnarView::operator[]: index out of range");
+  return *columns_[index];
+}
+
+const ColumnarView::Column* ColumnarView::find(const char* path) const {
+  return find(JSONCPP_STRING(path));
+}
+
+const ColumnarView::Column*
+ColumnarView::find(const JSONCPP_STRING& path) const {
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    if (columns_[i]->path_ == path)
+      return columns_[i];
+  }
+  return NULL;
+}
+
+// class ColumnarView::Column
+// //////////////////////////////////////////////////////////////////
+
+ColumnarView::Column::Column(const JSONCPP_STRING& path, ValueType type,
+                             ArrayIndex rows)
+    : path_(path), type_(type), size_(rows), validity_((rows + 63) / 64) {
+  switch (type) {
+  case booleanValue:
+    bools_.resize(rows);
+    break;
+  case intValue:
+    ints_.resize(rows);
+    break;
+  case uintValue:
+    uints_.resize(rows);
+    break;
+  case realValue:
+    reals_.resize(rows);
+    break;
+  case stringValue:
+    offsets_.resize(rows + 1U);
+    break;
+  default:
+    break;
+  }
+}
+
+const JSONCPP_STRING& ColumnarView::Column::path() const { return path_; }
+
+ValueType ColumnarView::Column::type() const { return type_; }
+
+ArrayIndex ColumnarView::Column::size() const { return size_; }
+
+bool ColumnarView::Column::isNull(ArrayIndex row) const {
+  JSON_ASSERT_MESSAGE(row < size_,
+                      "in Json::ColumnarView::Column::isNull(): row out of range");
+  return !(validity_[row / 64] & (UInt64(1) << (row % 64)));
+}
+
+const UInt64* ColumnarView::Column::validity() const {
+  return validity_.empty() ? NULL : &validity_[0];
+}
+
+const unsigned char* ColumnarView::Column::bools() const {
+  return type_ == booleanValue && size_ ? &bools_[0] : NULL;
+}
+
+const Int64* ColumnarView::Column::ints() const {
+  return type_ == intValue && size_ ? &ints_[0] : NULL;
+}
+
+const UInt64* ColumnarView::Column::uints() const {
+  return type_ == uintValue && size_ ? &uints_[0] : NULL;
+}
+
+const double* ColumnarView::Column::reals() const {
+  return type_ == realValue && size_ ? &reals_[0] : NULL;
+}
+
+const char* ColumnarView::Column::chars() const {
+  if (type_ != stringValue)
+    return NULL;
+  return chars_.empty() ? "" : &chars_[0];
+}
+
+const UInt64* ColumnarView::Column::offsets() const {
+  return type_ == stringValue ? &offsets_[0] : NULL;
+}
+
+bool ColumnarView::Column::getString(ArrayIndex row, char const** begin,
+                                     char const** end) const {
+  if (type_ != stringValue || row >= size_)
+    return false;
+  *begin = chars() + offsets_[row];
+  *end = chars() + offsets_[row + 1];
+  return true;
+}
+
+Value ColumnarView::Column::value(ArrayIndex row) const {
+  if (row >= size_ || isNull(row))
+    return Value();
+  switch (type_) {
+  case booleanValue:
+    return Value(bools_[row] != 0);
+  case intValue:
+    return Value(ints_[row]);
+  case uintValue:
+    return Value(uints_[row]);
+  case realValue:
+    return Value(reals_[row]);
+  case stringValue: {
+    char const* begin;
+    char const* end;
+    getString(row, &begin, &end);
+    return Value(begin, end);
+  }
+  default:
+    return Value();
+  }
+}
+
+} // namespace Json
+
+#endif // if defined(JSON_HAS_INT64)
@@ -0,0 +1,714 @@
+// Copyright 2007-2010 Baptiste Lepilleur
+// Distributed under MIT license, or public domain if desired and
+// recognized in your jurisdiction.
+// See file LICENSE for detail or copy at http://jsoncpp.sourceforge.net/LICENSE
+
+#if !defined(JSON_IS_AMALGAMATION)
+#include <json/assertions.h>
+#include <json/frozen.h>
+#endif // if !defined(JSON_IS_AMALGAMATION)
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(JSON_HAS_INT64)
+
+namespace Json {
+
+// A FrozenValue is one vector of 64-bit words: the number of words of the
+// tape, the tape, then the strings. The root is the first value on the tape.
+//
+// Every value on the tape starts with a word holding its ValueType in the
+// top 8 bits and, below them, a payload:
+//   nullValue                   0
+//   booleanValue                the value, 0 or 1
+//   intValue, uintValue,        0; the value takes the next word
+//     realValue
+//   stringValue                 the offset of the string in the strings
+//   arrayValue                  the number of elements; each of the next
+//                               words holds the index of an element
+//   objectValue                 the number of members; each of the next
+//                               pairs of words holds the offset of the name
+//                               of a member in the strings and the index of
+//                               its value, in name order
+// A string is stored as its length (a UInt), its characters and a null.
+//
+// A snapshot file is a header followed by the vector, as is: the tape only
+// holds indexes and offsets, so it reads the same wherever it is mapped.
+// The header is 32 bytes, keeping the tape aligned in the mapping:
+//   "JSONTAPE", the version of the format (a UInt), 0x01020304 in the byte
+//   order of the writer (a UInt), the number of words of the vector (a
+//   UInt64), and 8 bytes reserved.
+
+namespace {
+
+const unsigned typeShift = 56;
+const UInt64 payloadMask = (UInt64(1) << typeShift) - 1;
+
+inline UInt64 tag(ValueType type, UInt64 payload) {
+  return (UInt64(type) << typeShift) | payload;
+}
+
+// The tape of a null FrozenNode.
+const UInt64 nullTape[2] = {2, 0};
+
+const char snapshotMagic[8] = {'J', 'S', 'O', 'N', 'T', 'A', 'P', 'E'};
+const UInt snapshotVersion = 1;
+const UInt snapshotByteOrder = 0x01020304;
+const size_t snapshotHeaderSize = 32;
+
+inline const char* stringAt(const UInt64* tape, UInt64 offset,
+                            const char** end) {
+  const char* strings = reinterpret_cast<const char*>(tape + tape[0]);
+  UInt length;
+  memcpy(&length, strings + offset, sizeof(length));
+  const char* begin = strings + offset + sizeof(length);
+  *end = begin + length;
+  return begin;
+}
+
+class TapeBuilder {
+public:
+  TapeBuilder() : tape_(1, 0) {}
+
+  size_t add(const Value& value);
+  void finish(std::vector<UInt64>& buffer);
+
+private:
+  UInt64 addString(char const* begin, char const* end);
+  UInt64 addName(char const* name, unsigned length);
+
+  std::vector<UInt64> tape_;
+  JSONCPP_STRING strings_;
+  std::unordered_map<std::string, UInt64> names_;
+};
+
+size_t TapeBuilder::add(const Value& value) {
+  size_t index = tape_.size();
+  switch (value.type()) {
+  case nullValue:
+    tape_.push_back(tag(nullValue, 0));
+    break;
+  case booleanValue:
+    tape_.push_back(tag(booleanValue, value.asBool() ? 1 : 0));
+    break;
+  case intValue:
+    tape_.push_back(tag(intValue, 0));
+    tape_.push_back(static_cast<UInt64>(value.asLargestInt()));
+    break;
+  case uintValue:
+    tape_.push_back(tag(uintValue, 0));
+    tape_.push_back(value.asLargestUInt());
+    break;
+  case realValue: {
+    double number = value.asDouble();
+    UInt64 bits;
+    memcpy(&bits, &number, sizeof(bits));
+    tape_.push_back(tag(realValue, 0));
+    tape_.push_back(bits);
+  } break;
+  case stringValue: {
+    char const* begin;
+    char const* end;
+    UInt64 offset;
+    if (value.getString(&begin, &end)) {
+      offset = addString(begin, end);
+    } else {
+      JSONCPP_STRING text = value.asString();
+      offset = addString(text.data(), text.data() + text.length());
+    }
+    tape_.push_back(tag(stringValue, offset));
+  } break;
+  case arrayValue: {
+    ArrayIndex size = value.size();
+    tape_.push_back(tag(arrayValue, size));
+    tape_.resize(tape_.size() + size);
+    for (ArrayIndex i = 0; i < size; ++i) {
+      size_t element = add(value[i]);
+      tape_[index + 1 + i] = element;
+    }
+  } break;
+  case objectValue: {
+    ArrayIndex size = value.size();
+    tape_.push_back(tag(objectValue, size));
+    tape_.resize(tape_.size() + 2 * size);
+    size_t entry = index + 1;
+    value.forEachMember(
+        [this, &entry](char const* name, unsigned length, const Value& member) {
+          tape_[entry] = addName(name, length);
+          size_t at = add(member);
+          tape_[entry + 1] = at;
+          entry += 2;
+        });
+  } break;
+  }
+  return index;
+}
+
+UInt64 TapeBuilder::addString(char const* begin, char const* end) {
+  UInt64 offset = strings_.length();
+  UInt length = static_cast<UInt>(end - begin);
+  strings_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+  strings_.append(begin, end);
+  strings_.push_back('\0');
+  return offset;
+}
+
+UInt64 TapeBuilder::addName(char const* name, unsigned length) {
+  std::pair<std::unordered_map<std::string, UInt64>::iterator, bool> added =
+      names_.insert(std::make_pair(std::string(name, length), UInt64(0)));
+  if (added.second)
+    added.first->second = addString(name, name + length);
+  return added.first->second;
+}
+
+void TapeBuilder::finish(std::vector<UInt64>& buffer) {
+  size_t words = tape_.size();
+  size_t stringWords = (strings_.length() + sizeof(UInt64) - 1) / sizeof(UInt64);
+  tape_[0] = words;
+  buffer.reserve(words + stringWords);
+  buffer.assign(tape_.begin(), tape_.end());
+  buffer.resize(words + stringWords);
+  if (!strings_.empty())
+    memcpy(&buffer[words], strings_.data(), strings_.length());
+}
+
+inline void fail(JSONCPP_STRING* errs, const JSONCPP_STRING& message) {
+  if (errs)
+    *errs = message;
+}
+
+// Map the whole file at path read-only. Return NULL on failure.
+void* mapFile(const char* path, size_t* length, JSONCPP_STRING* errs) {
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    fail(errs, JSONCPP_STRING("Cannot open ") + path);
+    return NULL;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) ||
+      size.QuadPart < LONGLONG(snapshotHeaderSize)) {
+    CloseHandle(file);
+    fail(errs, path + JSONCPP_STRING(" is not a snapshot"));
+    return NULL;
+  }
+  *length = static_cast<size_t>(size.QuadPart);
+  void* view = NULL;
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping) {
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+  }
+  CloseHandle(file);
+  if (!view)
+    fail(errs, JSONCPP_STRING("Cannot map ") + path);
+  return view;
+#else
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    fail(errs, JSONCPP_STRING("Cannot open ") + path + ": " + strerror(errno));
+    return NULL;
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 ||
+      status.st_size < static_cast<off_t>(snapshotHeaderSize)) {
+    ::close(fd);
+    fail(errs, path + JSONCPP_STRING(" is not a snapshot"));
+    return NULL;
+  }
+  *length = static_cast<size_t>(status.st_size);
+  void* view = mmap(NULL, *length, PROT_READ, MAP_SHARED, fd, 0);
+  int error = errno;
+  ::close(fd);
+  if (view == MAP_FAILED) {
+    fail(errs, JSONCPP_STRING("Cannot map ") + path + ": " + strerror(error));
+    return NULL;
+  }
+  return view;
+#endif
+}
+
+void unmapFile(void* view, size_t length) {
+#if defined(_WIN32)
+  (void)length;
+  UnmapViewOfFile(view);
+#else
+  munmap(view, length);
+#endif
+}
+
+} // namespace
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class FrozenNode
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+FrozenNode::FrozenNode() : tape_(nullTape), index_(1) {}
+
+FrozenNode::FrozenNode(const UInt64* tape, size_t index)
+    : tape_(tape), index_(index) {}
+
+UInt64 FrozenNode::payload() const { return tape_[index_] & payloadMask; }
+
+ValueType FrozenNode::type() const {
+  return static_cast<ValueType>(tape_[index_] >> typeShift);
+}
+
+bool FrozenNode::isNull() const { return type() == nullValue; }
+
+bool FrozenNode::isBool() const { return type() == booleanValue; }
+
+bool FrozenNode::isInt() const { return isNumeric() && scalar().isInt(); }
+
+bool FrozenNode::isInt64() const { return isNumeric() && scalar().isInt64(); }
+
+bool FrozenNode::isUInt() const { return isNumeric() && scalar().isUInt(); }
+
+bool FrozenNode::isUInt64() const {
+  return isNumeric() && scalar().isUInt64();
+}
+
+bool FrozenNode::isIntegral() const {
+  return isNumeric() && scalar().isIntegral();
+}
+
+bool FrozenNode::isDouble() const {
+  ValueType t = type();
+  return t == intValue || t == uintValue || t == realValue;
+}
+
+bool FrozenNode::isNumeric() const { return isDouble(); }
+
+bool FrozenNode::isString() const { return type() == stringValue; }
+
+bool FrozenNode::isArray() const { return type() == arrayValue; }
+
+bool FrozenNode::isObject() const { return type() == objectValue; }
+
+// The scalar this node holds, to convert it by the rules of Value.
+Value FrozenNode::scalar() const {
+  switch (type()) {
+  case booleanValue:
+    return Value(payload() != 0);
+  case intValue:
+    return Value(static_cast<LargestInt>(tape_[index_ + 1]));
+  case uintValue:
+    return Value(static_cast<LargestUInt>(tape_[index_ + 1]));
+  case realValue: {
+    double number;
+    memcpy(&number, &tape_[index_ + 1], sizeof(number));
+    return Value(number);
+  }
+  case stringValue: {
+    char const* end;
+    char const* begin = stringAt(tape_, payload(), &end);
+    return Value(begin, end);
+  }
+  default:
+    return Value(type());
+  }
+}
+
+const char* FrozenNode::asCString() const {
+  JSON_ASSERT_MESSAGE(type() == stringValue,
+                      "in Json::FrozenNode::asCString(): requires stringValue");
+  char const* end;
+  return stringAt(tape_, payload(), &end);
+}
+
+bool FrozenNode::getString(char const** begin, char const** end) const {
+  if (type() != stringValue)
+    return false;
+  *begin = stringAt(tape_, payload(), end);
+  return true;
+}
+
+JSONCPP_STRING FrozenNode::asString() const {
+  char const* begin;
+  char const* end;
+  if (getString(&begin, &end))
+    return JSONCPP_STRING(begin, end);
+  return scalar().asString();
+}
+
+Int FrozenNode::asInt() const { return scalar().asInt(); }
+
+UInt FrozenNode::asUInt() const { return scalar().asUInt(); }
+
+Int64 FrozenNode::asInt64() const { return scalar().asInt64(); }
+
+UInt64 FrozenNode::asUInt64() const { return scalar().asUInt64(); }
+
+LargestInt FrozenNode::asLargestInt() const { return scalar().asLargestInt(); }
+
+LargestUInt FrozenNode::asLargestUInt() const {
+  return scalar().asLargestUInt();
+}
+
+float FrozenNode::asFloat() const { return scalar().asFloat(); }
+
+double FrozenNode::asDouble() const { return scalar().asDouble(); }
+
+bool FrozenNode::asBool() const { return scalar().asBool(); }
+
+ArrayIndex FrozenNode::size() const {
+  ValueType t = type();
+  if (t == arrayValue || t == objectValue)
+    return ArrayIndex(payload());
+  return 0;
+}
+
+bool FrozenNode::empty() const {
+  if (isNull() || isArray() || isObject())
+    return size() == 0u;
+  else
+    return false;
+}
+
+FrozenNode FrozenNode::operator[](ArrayIndex index) const {
+  JSON_ASSERT_MESSAGE(
+      type() == nullValue || type() == arrayValue,
+      "in Json::FrozenNode::operator[](ArrayIndex): requires arrayValue");
+  if (type() == nullValue || index >= payload())
+    return FrozenNode();
+  return FrozenNode(tape_, static_cast<size_t>(tape_[index_ + 1 + index]));
+}
+
+FrozenNode FrozenNode::operator[](int index) const {
+  JSON_ASSERT_MESSAGE(
+      index >= 0,
+      "in Json::FrozenNode::operator[](int index): index cannot be negative");
+  return (*this)[ArrayIndex(index)];
+}
+
+FrozenNode FrozenNode::operator[](const char* key) const {
+  FrozenNode member;
+  find(key, key + strlen(key), &member);
+  return member;
+}
+
+FrozenNode FrozenNode::operator[](const JSONCPP_STRING& key) const {
+  FrozenNode member;
+  find(key.data(), key.data() + key.length(), &member);
+  return member;
+}
+
+bool FrozenNode::find(const char* begin, const char* end,
+                      FrozenNode* member) const {
+  JSON_ASSERT_MESSAGE(
+      type() == nullValue || type() == objectValue,
+      "in Json::FrozenNode::find(key, end, found): requires objectValue or nullValue");
+  if (type() != objectValue)
+    return false;
+  size_t length = static_cast<size_t>(end - begin);
+  size_t low = 0;
+  size_t high = static_cast<size_t>(payload());
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    size_t entry = index_ + 1 + 2 * middle;
+    char const* nameEnd;
+    char const* name = stringAt(tape_, tape_[entry], &nameEnd);
+    size_t nameLength = static_cast<size_t>(nameEnd - name);
+    // The order of Value::CZString.
+    int comp = memcmp(name, begin, std::min(nameLength, length));
+    if (comp == 0 && nameLength != length)
+      comp = nameLength < length ? -1 : 1;
+    if (comp < 0) {
+      low = middle + 1;
+    } else if (comp > 0) {
+      high = middle;
+    } else {
+      *member = FrozenNode(tape_, static_cast<size_t>(tape_[entry + 1]));
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FrozenNode::isMember(const char* key) const {
+  FrozenNode member;
+  return find(key, key + strlen(key), &member);
+}
+
+bool FrozenNode::isMember(const JSONCPP_STRING& key) const {
+  FrozenNode member;
+  return find(key.data(), key.data() + key.length(), &member);
+}
+
+FrozenNode::const_iterator FrozenNode::begin() const {
+  ValueType t = type();
+  if (t != arrayValue && t != objectValue)
+    return const_iterator();
+  return const_iterator(tape_, index_ + 1, index_ + 1, t == objectValue);
+}
+
+FrozenNode::const_iterator FrozenNode::end() const {
+  ValueType t = type();
+  if (t != arrayValue && t != objectValue)
+    return const_iterator();
+  size_t entries = static_cast<size_t>(payload()) * (t == objectValue ? 2 : 1);
+  return const_iterator(tape_, index_ + 1, index_ + 1 + entries,
+                        t == objectValue);
+}
+
+Value FrozenNode::toValue() const {
+  switch (type()) {
+  case arrayValue: {
+    Value array(arrayValue);
+    array.reserve(size());
+    for (const_iterator it = begin(); it != end(); ++it)
+      array.append((*it).toValue());
+    array.unpin();
+    return array;
+  }
+  case objectValue: {
+    Value object(objectValue);
+    object.reserve(size());
+    for (const_iterator it = begin(); it != end(); ++it) {
+      char const* nameEnd;
+      char const* name = it.memberName(&nameEnd);
+      Value member = (*it).toValue();
+      object.placeMember(name, nameEnd, member, true);
+    }
+    object.unpin();
+    return object;
+  }
+  default:
+    return scalar();
+  }
+}
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class FrozenNode::const_iterator
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+FrozenNode::const_iterator::const_iterator()
+    : tape_(0), first_(0), entry_(0), object_(false) {}
+
+FrozenNode::const_iterator::const_iterator(const UInt64* tape, size_t first,
+                                           size_t entry, bool object)
+    : tape_(tape), first_(first), entry_(entry), object_(object) {}
+
+FrozenNode FrozenNode::const_iterator::operator*() const {
+  return FrozenNode(tape_,
+                    static_cast<size_t>(tape_[object_ ? entry_ + 1 : entry_]));
+}
+
+FrozenNode::const_iterator& FrozenNode::const_iterator::operator++() {
+  entry_ += object_ ? 2 : 1;
+  return *this;
+}
+
+FrozenNode::const_iterator FrozenNode::const_iterator::operator++(int) {
+  const_iterator temp(*this);
+  ++*this;
+  return temp;
+}
+
+UInt FrozenNode::const_iterator::index() const {
+  if (object_ || !tape_)
+    return UInt(-1);
+  return UInt(entry_ - first_);
+}
+
+JSONCPP_STRING FrozenNode::const_iterator::name() const {
+  char const* end;
+  char const* key = memberName(&end);
+  if (!key)
+    return JSONCPP_STRING();
+  return JSONCPP_STRING(key, end);
+}
+
+char const* FrozenNode::const_iterator::memberName(char const** end) const {
+  if (!object_) {
+    *end = NULL;
+    return NULL;
+  }
+  return stringAt(tape_, tape_[entry_], end);
+}
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class FrozenValue
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+FrozenValue::FrozenValue() {}
+
+FrozenValue::FrozenValue(const Value& value) {
+  TapeBuilder builder;
+  builder.add(value);
+  builder.finish(buffer_);
+  attach();
+}
+
+FrozenValue::FrozenValue(const FrozenValue& other)
+    : FrozenNode(), buffer_(other.buffer_) {
+  attach();
+}
+
+#if JSON_HAS_RVALUE_REFERENCES
+FrozenValue::FrozenValue(FrozenValue&& other)
+    : FrozenNode(), buffer_(std::move(other.buffer_)) {
+  attach();
+  other.attach();
+}
+#endif
+
+FrozenValue& FrozenValue::operator=(FrozenValue other) {
+  swap(other);
+  return *this;
+}
+
+void FrozenValue::swap(FrozenValue& other) {
+  buffer_.swap(other.buffer_);
+  attach();
+  other.attach();
+}
+
+void FrozenValue::attach() {
+  tape_ = buffer_.empty() ? nullTape : &buffer_[0];
+  index_ = 1;
+}
+
+bool FrozenValue::parse(const CharReaderBuilder& builder, char const* begin,
+                        char const* end, FrozenValue* root,
+                        JSONCPP_STRING* errs) {
+  // The document is only read into an arena, to be frozen and dropped at
+  // once.
+  Arena arena(std::max<size_t>(64 * 1024, static_cast<size_t>(end - begin)));
+  Value document(arena);
+  std::unique_ptr<CharReader> const reader(builder.newCharReader());
+  if (!reader->parse(begin, end, &document, errs))
+    return false;
+  FrozenValue(document).swap(*root);
+  return true;
+}
+
+size_t FrozenValue::byteSize() const {
+  return buffer_.size() * sizeof(UInt64);
+}
+
+void FrozenValue::writeSnapshot(JSONCPP_OSTREAM& out) const {
+  const UInt64* words = buffer_.empty() ? nullTape : &buffer_[0];
+  UInt64 count = buffer_.empty() ? 2 : buffer_.size();
+  char header[snapshotHeaderSize] = {0};
+  memcpy(header, snapshotMagic, sizeof(snapshotMagic));
+  memcpy(header + 8, &snapshotVersion, sizeof(snapshotVersion));
+  memcpy(header + 12, &snapshotByteOrder, sizeof(snapshotByteOrder));
+  memcpy(header + 16, &count, sizeof(count));
+  out.write(header, sizeof(header));
+  out.write(reinterpret_cast<const char*>(words),
+            static_cast<std::streamsize>(count * sizeof(UInt64)));
+}
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class FrozenSnapshot
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+FrozenSnapshot::FrozenSnapshot() : mapping_(0), length_(0) {}
+
+FrozenSnapshot::~FrozenSnapshot() { close(); }
+
+#if JSON_HAS_RVALUE_REFERENCES
+FrozenSnapshot::FrozenSnapshot(FrozenSnapshot&& other)
+    : FrozenNode(), mapping_(0), length_(0) {
+  swap(other);
+}
+#endif
+
+void FrozenSnapshot::swap(FrozenSnapshot& other) {
+  std::swap(tape_, other.tape_);
+  std::swap(index_, other.index_);
+  std::swap(mapping_, other.mapping_);
+  std::swap(length_, other.length_);
+}
+
+bool FrozenSnapshot::open(const char* path, JSONCPP_STRING* errs) {
+  size_t length = 0;
+  void* mapping = mapFile(path, &length, errs);
+  if (!mapping)
+    return false;
+  const char* header = static_cast<const char*>(mapping);
+  UInt version;
+  UInt byteOrder;
+  UInt64 count;
+  memcpy(&version, header + 8, sizeof(version));
+  memcpy(&byteOrder, header + 12, sizeof(byteOrder));
+  memcpy(&count, header + 16, sizeof(count));
+  const UInt64* tape =
+      reinterpret_cast<const UInt64*>(header + snapshotHeaderSize);
+  const char* error = 0;
+  if (memcmp(header, snapshotMagic, sizeof(snapshotMagic)) != 0)
+    error = " is not a snapshot";
+  else if (version != snapshotVersion)
+    error = " is a snapshot of an unknown version";
+  else if (byteOrder != snapshotByteOrder)
+    error = " is a snapshot of another byte order";
+  else if ((length - snapshotHeaderSize) % sizeof(UInt64) != 0 ||
+           count != (length - snapshotHeaderSize) / sizeof(UInt64) ||
+           count < 2 || tape[0] < 2 || tape[0] > count)
+    error = " is a snapshot of the wrong size";
+  if (error) {
+    unmapFile(mapping, length);
+    fail(errs, path + JSONCPP_STRING(error));
+    return false;
+  }
+  close();
+  mapping_ = mapping;
+  length_ = length;
+  tape_ = tape;
+  index_ = 1;
+  return true;
+}
+
+void FrozenSnapshot::close() {
+  if (mapping_)
+    unmapFile(mapping_, length_);
+  mapping_ = 0;
+  length_ = 0;
+  tape_ = nullTape;
+  index_ = 1;
+}
+
+size_t FrozenSnapshot::byteSize() const {
+  return length_ ? length_ - snapshotHeaderSize : 0;
+}
+
+} // namespace Json
+
+#endif // if defined(JSON_HAS_INT64)
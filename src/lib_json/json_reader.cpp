@@ -74,6 +74,14 @@ public:
   bool failIfExtra_;
   bool rejectDupKeys_;
   bool allowSpecialFloats_;
+  bool collectOffsets_;
+  bool internKeys_;
+  bool sizeHints_;
+  bool lazyNumbers_;
+  bool lazyStrings_;
+  bool reuseValues_;
+  bool packNumbers_;
+  bool shareShapes_;
   int stackLimit_;
 };  // Features
 
@@ -97,6 +105,7 @@ public:
   };
 
   OurReader(Features const& features);
+  ~OurReader();
   void init(const char* beginDoc,
             const char* endDoc,
             bool collectComments = true);
@@ -157,6 +166,7 @@ private:
   bool decodeNumber(const Token& token);
   bool decodeNumber(const Token& token, Value& decoded);
   bool decodeString(const Token& token);
+  bool checkEscapes(const Token& token, bool& escaped, bool& verbatim);
   bool decodeDouble(const Token& token);
   bool decodeDouble(const Token& token, Value& decoded);
   bool decodeUnicodeCodePoint(const Token& token,
@@ -169,10 +179,16 @@ private:
                                    unsigned int& unicode);
 
   Value& currentValue();
+  void setOffsetStart(ptrdiff_t start);
+  void setOffsetLimit(ptrdiff_t limit);
   char getNextChar();
   void getLocationLineAndColumn(const ptrdiff_t offset, ErrorLocation& location) const;
   void addComment(const char* begin, const char* end, CommentPlacement placement);
   void skipCommentTokens(Token& token);
+  char const* internName(JSONCPP_STRING const& name);
+  void reserveFromSizeHint();
+  void recordSizeHint();
+  void shareShape();
 
   typedef std::stack<Value*> Nodes;
   Nodes nodes_;
@@ -187,6 +203,30 @@ private:
 
   Features const features_;
   bool collectComments_;
+
+  // Names recently interned by this reader, by hash of the name, so that
+  // repeated names do not take the lock of the KeyPool.
+  struct InternedName {
+    char const* name;
+    unsigned length;
+  };
+  static const unsigned internCacheSize = 256;
+  InternedName internCache_[internCacheSize];
+
+  // Size of the last array or object completed at each depth, kept across
+  // documents.
+  std::vector<ArrayIndex> sizeHints_;
+
+  // Shape of the last objects completed at each depth, and hash of the
+  // names of the last one left without, kept across documents.
+  std::vector<Value::Shape*> shapes_;
+  std::vector<UInt> shapeCandidates_;
+
+  // Buffer of the strings decoded with reuseValues_, kept across documents.
+  JSONCPP_STRING decodedString_;
+
+  // Arena of the root being read, which holds the whole document, or NULL.
+  Arena* arena_;
 };  // OurReader
 
 static bool containsNewLine(const char* begin, const char* end) {
@@ -202,7 +242,13 @@ static bool containsNewLine(const char* begin, const char* end) {
 OurReader::OurReader(Features const& features)
     : errors_(), document_(), begin_(), end_(), current_(), lastValueEnd_(),
       lastValue_(), commentsBefore_(),
-      features_(features), collectComments_() {
+      features_(features), collectComments_(), arena_() {
+  memset(internCache_, 0, sizeof(internCache_));
+}
+
+OurReader::~OurReader() {
+  for (size_t depth = 0; depth < shapes_.size(); ++depth)
+    Value::releaseShape(shapes_[depth]);
 }
 
 void OurReader::init(const char* beginDoc,
@@ -227,6 +273,7 @@ bool OurReader::parse(Value& root) {
   while (!nodes_.empty())
     nodes_.pop();
   nodes_.push(&root);
+  arena_ = root.arena();
 
   bool successful = readValue();
   Token token;
@@ -270,11 +317,25 @@ bool OurReader::readValue() {
   switch (token.type_) {
   case tokenObjectBegin:
     successful = readObject(token);
-    currentValue().setOffsetLimit(current_ - begin_);
+    if (features_.reuseValues_)
+      currentValue().finishReuse();
+    if (features_.shareShapes_ && successful)
+      shareShape();
+    // No reference into the elements outlives their parsing, so arrays and
+    // objects may be shared by the copies of the document.
+    currentValue().unpin();
+    if (features_.sizeHints_)
+      recordSizeHint();
+    setOffsetLimit(current_ - begin_);
     break;
   case tokenArrayBegin:
     successful = readArray(token);
-    currentValue().setOffsetLimit(current_ - begin_);
+    if (features_.reuseValues_)
+      currentValue().finishReuse();
+    currentValue().unpin();
+    if (features_.sizeHints_)
+      recordSizeHint();
+    setOffsetLimit(current_ - begin_);
     break;
   case tokenNumber:
     successful = decodeNumber(token);
@@ -286,48 +347,48 @@ bool OurReader::readValue() {
     {
     Value v(true);
     currentValue().swapPayload(v);
-    currentValue().setOffsetStart(token.offsetStart_);
-    currentValue().setOffsetLimit(token.offsetEnd_);
+    setOffsetStart(token.offsetStart_);
+    setOffsetLimit(token.offsetEnd_);
     }
     break;
   case tokenFalse:
     {
     Value v(false);
     currentValue().swapPayload(v);
-    currentValue().setOffsetStart(token.offsetStart_);
-    currentValue().setOffsetLimit(token.offsetEnd_);
+    setOffsetStart(token.offsetStart_);
+    setOffsetLimit(token.offsetEnd_);
     }
     break;
   case tokenNull:
     {
     Value v;
     currentValue().swapPayload(v);
-    currentValue().setOffsetStart(token.offsetStart_);
-    currentValue().setOffsetLimit(token.offsetEnd_);
+    setOffsetStart(token.offsetStart_);
+    setOffsetLimit(token.offsetEnd_);
     }
     break;
   case tokenNaN:
     {
     Value v(std::numeric_limits<double>::quiet_NaN());
     currentValue().swapPayload(v);
-    currentValue().setOffsetStart(token.offsetStart_);
-    currentValue().setOffsetLimit(token.offsetEnd_);
+    setOffsetStart(token.offsetStart_);
+    setOffsetLimit(token.offsetEnd_);
     }
     break;
   case tokenPosInf:
     {
     Value v(std::numeric_limits<double>::infinity());
     currentValue().swapPayload(v);
-    currentValue().setOffsetStart(token.offsetStart_);
-    currentValue().setOffsetLimit(token.offsetEnd_);
+    setOffsetStart(token.offsetStart_);
+    setOffsetLimit(token.offsetEnd_);
     }
     break;
   case tokenNegInf:
     {
     Value v(-std::numeric_limits<double>::infinity());
     currentValue().swapPayload(v);
-    currentValue().setOffsetStart(token.offsetStart_);
-    currentValue().setOffsetLimit(token.offsetEnd_);
+    setOffsetStart(token.offsetStart_);
+    setOffsetLimit(token.offsetEnd_);
     }
     break;
   case tokenArraySeparator:
@@ -339,13 +400,13 @@ bool OurReader::readValue() {
       current_--;
       Value v;
       currentValue().swapPayload(v);
-      currentValue().setOffsetStart(current_ - begin_ - 1);
-      currentValue().setOffsetLimit(current_ - begin_);
+      setOffsetStart(current_ - begin_ - 1);
+      setOffsetLimit(current_ - begin_);
       break;
     } // else, fall through ...
   default:
-    currentValue().setOffsetStart(token.offsetStart_);
-    currentValue().setOffsetLimit(token.offsetEnd_);
+    setOffsetStart(token.offsetStart_);
+    setOffsetLimit(token.offsetEnd_);
     return addError("Syntax error: value, object or array expected.", token);
   }
 
@@ -621,9 +682,17 @@ bool OurReader::readStringSingleQuote() {
 bool OurReader::readObject(Token& tokenStart) {
   Token tokenName;
   JSONCPP_STRING name;
-  Value init(objectValue);
-  currentValue().swapPayload(init);
-  currentValue().setOffsetStart(tokenStart.offsetStart_);
+  // Read the members over those of the object already there, if reusing.
+  bool reuse = features_.reuseValues_ && currentValue().isObject();
+  if (reuse) {
+    currentValue().startReuse();
+  } else {
+    Value init(objectValue, arena_);
+    currentValue().swapPayload(init);
+  }
+  if (features_.sizeHints_)
+    reserveFromSizeHint();
+  setOffsetStart(tokenStart.offsetStart_);
   while (readToken(tokenName)) {
     bool initialTokenOk = true;
     while (tokenName.type_ == tokenComment && initialTokenOk)
@@ -651,15 +720,32 @@ bool OurReader::readObject(Token& tokenStart) {
           "Missing ':' after object member name", colon, tokenObjectEnd);
     }
     if (name.length() >= (1U<<30)) throwRuntimeError("keylength >= 2^30");
-    if (features_.rejectDupKeys_ && currentValue().isMember(name)) {
+    // A member reused is one of the previous document, not a duplicate.
+    Value* reused = reuse ? currentValue().reuseMember(
+                                name.data(), name.data() + name.length())
+                          : 0;
+    if (features_.rejectDupKeys_ && !reused && currentValue().isMember(name)) {
       JSONCPP_STRING msg = "Duplicate key: '" + name + "'";
       return addErrorAndRecover(
           msg, tokenName, tokenObjectEnd);
     }
-    Value& value = currentValue()[name];
-    nodes_.push(&value);
+    Value value;
+    nodes_.push(reused ? reused : &value);
     bool ok = readValue();
     nodes_.pop();
+    if (reused) {
+      if (!ok)
+        lastValue_ = reused;
+    } else {
+      char const* interned = features_.internKeys_ ? internName(name) : 0;
+      Value& member =
+          interned ? currentValue().insert(StaticString(interned), std::move(value))
+                   : currentValue().insert(name, std::move(value));
+      // Inserting may move the other members of a small object: comments
+      // read from now on go to the new member.
+      if (lastValue_ == &value || !ok)
+        lastValue_ = &member;
+    }
     if (!ok) // error already set
       return recoverFromError(tokenObjectEnd);
 
@@ -680,10 +766,62 @@ bool OurReader::readObject(Token& tokenStart) {
       "Missing '}' or object member name", tokenName, tokenObjectEnd);
 }
 
+// \return NULL if the name cannot be interned.
+char const* OurReader::internName(JSONCPP_STRING const& name) {
+  unsigned length = static_cast<unsigned>(name.length());
+  UInt hash = 2166136261u; // FNV-1a
+  for (unsigned i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(name[i]);
+    hash *= 16777619u;
+  }
+  InternedName& cached = internCache_[hash % internCacheSize];
+  if (cached.name && cached.length == length &&
+      memcmp(cached.name, name.data(), length) == 0)
+    return cached.name;
+  char const* interned = KeyPool::intern(name.data(), name.data() + length);
+  if (interned) {
+    cached.name = interned;
+    cached.length = length;
+  }
+  return interned;
+}
+
+// Siblings are often alike, as the records of an array, so the current array
+// or object makes room for as many elements as the last one at its depth.
+void OurReader::reserveFromSizeHint() {
+  size_t depth = nodes_.size();
+  if (depth < sizeHints_.size() && sizeHints_[depth])
+    currentValue().reserve(sizeHints_[depth]);
+}
+
+void OurReader::recordSizeHint() {
+  size_t depth = nodes_.size();
+  if (depth >= sizeHints_.size())
+    sizeHints_.resize(depth + 1);
+  sizeHints_[depth] = currentValue().size();
+}
+
+// Likewise, the current object shares the names of its members with the last
+// ones at its depth, when they are the same.
+void OurReader::shareShape() {
+  size_t depth = nodes_.size();
+  if (depth >= shapes_.size()) {
+    shapes_.resize(depth + 1);
+    shapeCandidates_.resize(depth + 1);
+  }
+  currentValue().shareShape(shapes_[depth], shapeCandidates_[depth]);
+}
+
 bool OurReader::readArray(Token& tokenStart) {
-  Value init(arrayValue);
-  currentValue().swapPayload(init);
-  currentValue().setOffsetStart(tokenStart.offsetStart_);
+  // Read the elements over those of the array already there, if reusing.
+  bool reuse = features_.reuseValues_ && currentValue().isArray();
+  if (reuse) {
+    currentValue().startReuse();
+  } else {
+    Value init(arrayValue, arena_);
+    currentValue().swapPayload(init);
+  }
+  setOffsetStart(tokenStart.offsetStart_);
   skipSpaces();
   if (current_ != end_ && *current_ == ']') // empty array
   {
@@ -691,12 +829,25 @@ bool OurReader::readArray(Token& tokenStart) {
     readToken(endArray);
     return true;
   }
-  int index = 0;
-  for (;;) {
-    Value& value = currentValue()[index++];
-    nodes_.push(&value);
+  if (features_.sizeHints_)
+    reserveFromSizeHint();
+  Value& array = currentValue();
+  for (ArrayIndex index = 0;; ++index) {
+    Value* reused = reuse ? array.reuseElement(index) : 0;
+    Value value;
+    nodes_.push(reused ? reused : &value);
     bool ok = readValue();
     nodes_.pop();
+    if (reused) {
+      if (!ok)
+        lastValue_ = reused;
+    } else {
+      Value& element = array.append(std::move(value));
+      // Appending may relocate the other elements: comments read from now
+      // on go to the new one.
+      if (lastValue_ == &value || !ok)
+        lastValue_ = &element;
+    }
     if (!ok) // error already set
       return recoverFromError(tokenArrayEnd);
 
@@ -715,6 +866,9 @@ bool OurReader::readArray(Token& tokenStart) {
     if (token.type_ == tokenArrayEnd)
       break;
   }
+  // Comments are only ever attached to the array from now on.
+  if (features_.packNumbers_ && !reuse)
+    array.packNumbers();
   return true;
 }
 
@@ -737,8 +891,8 @@ bool OurReader::decodeNumber(const Token& token) {
   if (!decodeNumber(token, decoded))
     return false;
   currentValue().swapPayload(decoded);
-  currentValue().setOffsetStart(token.offsetStart_);
-  currentValue().setOffsetLimit(token.offsetEnd_);
+  setOffsetStart(token.offsetStart_);
+  setOffsetLimit(token.offsetEnd_);
   return true;
 }
 
@@ -788,8 +942,8 @@ bool OurReader::decodeDouble(const Token& token) {
   if (!decodeDouble(token, decoded))
     return false;
   currentValue().swapPayload(decoded);
-  currentValue().setOffsetStart(token.offsetStart_);
-  currentValue().setOffsetLimit(token.offsetEnd_);
+  setOffsetStart(token.offsetStart_);
+  setOffsetLimit(token.offsetEnd_);
   return true;
 }
 
@@ -832,6 +986,20 @@ bool OurReader::decodeDouble(const Token& token, double& decoded) {
 }
 
 bool OurReader::decodeDouble(const Token& token, Value& decoded) {
+  if (features_.lazyNumbers_) {
+    // Keep the text of any number sscanf() is sure to read, and decode it
+    // when it is used.
+    const char* current = token.offsetStart_ + begin_;
+    const char* end = token.offsetEnd_ + begin_;
+    for (const char* c = current; c != end && *c != 'e' && *c != 'E'; ++c) {
+      if (*c >= '0' && *c <= '9') {
+        Value lazy(realValue);
+        lazy.initNumberText(current, end, arena_);
+        decoded = lazy;
+        return true;
+      }
+    }
+  }
   double value = 0;
   if (decodeDouble(token, value) == false)
     return false;
@@ -840,13 +1008,46 @@ bool OurReader::decodeDouble(const Token& token, Value& decoded) {
 }
 
 bool OurReader::decodeString(const Token& token) {
+  if (features_.lazyStrings_ && begin_[token.offsetStart_] == '"') {
+    // Keep the escaped text, to be unescaped when it is used. Strings with
+    // escapes are unescaped now in an arena, which cannot hold them later.
+    bool escaped;
+    bool verbatim;
+    if (!checkEscapes(token, escaped, verbatim))
+      return false;
+    if (!escaped || !arena_) {
+      Value decoded(stringValue);
+      decoded.initRawString(token.offsetStart_ + begin_ + 1,
+                            token.offsetEnd_ + begin_ - 1, escaped, verbatim,
+                            arena_);
+      currentValue().swapPayload(decoded);
+      setOffsetStart(token.offsetStart_);
+      setOffsetLimit(token.offsetEnd_);
+      return true;
+    }
+  }
+  if (features_.reuseValues_) {
+    // Decode into a buffer kept for the purpose, then into the string
+    // already there if it is long enough.
+    decodedString_.clear();
+    if (!decodeString(token, decodedString_))
+      return false;
+    currentValue().reuseString(decodedString_.data(),
+                               static_cast<unsigned>(decodedString_.length()),
+                               arena_);
+    setOffsetStart(token.offsetStart_);
+    setOffsetLimit(token.offsetEnd_);
+    return true;
+  }
   JSONCPP_STRING decoded_string;
   if (!decodeString(token, decoded_string))
     return false;
-  Value decoded(decoded_string);
+  Value decoded(stringValue);
+  decoded.initString(decoded_string.data(),
+                     static_cast<unsigned>(decoded_string.length()), arena_);
   currentValue().swapPayload(decoded);
-  currentValue().setOffsetStart(token.offsetStart_);
-  currentValue().setOffsetLimit(token.offsetEnd_);
+  setOffsetStart(token.offsetStart_);
+  setOffsetLimit(token.offsetEnd_);
   return true;
 }
 
@@ -903,6 +1104,55 @@ bool OurReader::decodeString(const Token& token, JSONCPP_STRING& decoded) {
   return true;
 }
 
+// Check the escape sequences of a string, as decodeString() would, without
+// decoding it. verbatim tells whether the text is the one writers would
+// output for the string: no control characters, and only the escapes they
+// make.
+bool OurReader::checkEscapes(const Token& token, bool& escaped,
+                             bool& verbatim) {
+  const char* current = token.offsetStart_ + begin_ + 1; // skip '"'
+  const char* end = token.offsetEnd_ + begin_ - 1;       // do not include '"'
+  escaped = false;
+  verbatim = true;
+  for (const char* c = current; c != end && verbatim; ++c)
+    verbatim = static_cast<unsigned char>(*c) >= 0x20;
+  while ((current = static_cast<const char*>(memchr(
+              current, '\\', static_cast<size_t>(end - current)))) != 0) {
+    escaped = true;
+    if (++current == end)
+      return addError("Empty escape sequence in string", token, current);
+    char escape = *current++;
+    switch (escape) {
+    case '"':
+    case '/':
+    case '\\':
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+      break;
+    case 'u': {
+      // Writers only escape the other control characters, as \u00XX in
+      // upper case.
+      const char* hex = current;
+      unsigned int unicode;
+      if (!decodeUnicodeCodePoint(token, current, end, unicode))
+        return false;
+      if (unicode >= 0x20 || unicode == '\b' || unicode == '\f' ||
+          unicode == '\n' || unicode == '\r' || unicode == '\t' ||
+          (hex[3] >= 'a' && hex[3] <= 'f'))
+        verbatim = false;
+    } break;
+    default:
+      return addError("Bad escape sequence in string", token, current);
+    }
+    if (escape == '/')
+      verbatim = false;
+  }
+  return true;
+}
+
 bool OurReader::decodeUnicodeCodePoint(const Token& token,
                                        const char*& current,
                                        const char* end,
@@ -994,6 +1244,16 @@ bool OurReader::addErrorAndRecover(const JSONCPP_STRING& message,
 
 Value& OurReader::currentValue() { return *(nodes_.top()); }
 
+void OurReader::setOffsetStart(ptrdiff_t start) {
+  if (features_.collectOffsets_)
+    currentValue().setOffsetStart(start);
+}
+
+void OurReader::setOffsetLimit(ptrdiff_t limit) {
+  if (features_.collectOffsets_)
+    currentValue().setOffsetLimit(limit);
+}
+
 char OurReader::getNextChar() {
   if (current_ == end_)
     return 0;
@@ -1379,6 +1639,14 @@ Tokenizer* TokenizerBuilder::newTokenizer() const
     features.failIfExtra_ = settings_["failIfExtra"].asBool();
     features.rejectDupKeys_ = settings_["rejectDupKeys"].asBool();
     features.allowSpecialFloats_ = settings_["allowSpecialFloats"].asBool();
+    features.collectOffsets_ = false;
+    features.internKeys_ = false;
+    features.sizeHints_ = false;
+    features.lazyNumbers_ = false;
+    features.lazyStrings_ = false;
+    features.reuseValues_ = false;
+    features.packNumbers_ = false;
+    features.shareShapes_ = false;
     return new OurTokenizer(features);
 }
 static void getValidTokenizerKeys(std::set<JSONCPP_STRING>* valid_keys)
@@ -1493,12 +1761,21 @@ CharReader* CharReaderBuilder::newCharReader() const
   features.failIfExtra_ = settings_["failIfExtra"].asBool();
   features.rejectDupKeys_ = settings_["rejectDupKeys"].asBool();
   features.allowSpecialFloats_ = settings_["allowSpecialFloats"].asBool();
+  features.collectOffsets_ = settings_["collectOffsets"].asBool();
+  features.internKeys_ = settings_["internKeys"].asBool();
+  features.sizeHints_ = settings_["sizeHints"].asBool();
+  features.lazyNumbers_ = settings_["lazyNumbers"].asBool();
+  features.lazyStrings_ = settings_["lazyStrings"].asBool();
+  features.reuseValues_ = settings_["reuseValues"].asBool();
+  features.packNumbers_ = settings_["packNumbers"].asBool();
+  features.shareShapes_ = settings_["shareShapes"].asBool();
   return new OurCharReader(collectComments, features);
 }
 static void getValidReaderKeys(std::set<JSONCPP_STRING>* valid_keys)
 {
   valid_keys->clear();
   valid_keys->insert("collectComments");
+  valid_keys->insert("collectOffsets");
   valid_keys->insert("allowComments");
   valid_keys->insert("strictRoot");
   valid_keys->insert("allowDroppedNullPlaceholders");
@@ -1508,6 +1785,13 @@ static void getValidReaderKeys(std::set<JSONCPP_STRING>* valid_keys)
   valid_keys->insert("failIfExtra");
   valid_keys->insert("rejectDupKeys");
   valid_keys->insert("allowSpecialFloats");
+  valid_keys->insert("internKeys");
+  valid_keys->insert("sizeHints");
+  valid_keys->insert("lazyNumbers");
+  valid_keys->insert("lazyStrings");
+  valid_keys->insert("reuseValues");
+  valid_keys->insert("packNumbers");
+  valid_keys->insert("shareShapes");
 }
 bool CharReaderBuilder::validate(Json::Value* invalid) const
 {
@@ -1550,6 +1834,8 @@ void CharReaderBuilder::setDefaults(Json::Value* settings)
 {
 //! [CharReaderBuilderDefaults]
   (*settings)["collectComments"] = true;
+  // Costs a side-table record and a lock per parsed value when true.
+  (*settings)["collectOffsets"] = false;
   (*settings)["allowComments"] = true;
   (*settings)["strictRoot"] = false;
   (*settings)["allowDroppedNullPlaceholders"] = false;
@@ -1559,6 +1845,13 @@ void CharReaderBuilder::setDefaults(Json::Value* settings)
   (*settings)["failIfExtra"] = false;
   (*settings)["rejectDupKeys"] = false;
   (*settings)["allowSpecialFloats"] = false;
+  (*settings)["internKeys"] = false;
+  (*settings)["sizeHints"] = false;
+  (*settings)["lazyNumbers"] = false;
+  (*settings)["lazyStrings"] = false;
+  (*settings)["reuseValues"] = false;
+  (*settings)["packNumbers"] = false;
+  (*settings)["shareShapes"] = false;
 //! [CharReaderBuilderDefaults]
 }
 
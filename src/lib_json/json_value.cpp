@@ -7,8 +7,10 @@
 #include <json/assertions.h>
 #include <json/value.h>
 #include <json/writer.h>
+#include "json_tool.h"
 #endif // if !defined(JSON_IS_AMALGAMATION)
 #include <math.h>
+#include <stdio.h>
 #include <sstream>
 #include <utility>
 #include <cstring>
@@ -18,6 +20,13 @@
 #endif
 #include <cstddef> // size_t
 #include <algorithm> // min()
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new> // placement new
+#include <thread>
+#include <unordered_set>
 
 #define JSON_ASSERT_UNREACHABLE assert(false)
 
@@ -113,26 +122,62 @@ static inline char* duplicateStringValue(const char* value,
   return newString;
 }
 
+/* A prefixed string is shared by the copies of a Value: it starts with a
+ * reference count, the length of the string and the length it was allocated
+ * for, which Value::reuseString() may overwrite with shorter strings.
+ */
+struct StringPrefix {
+  explicit StringPrefix(unsigned length)
+      : refs_(1), length_(length), capacity_(length) {}
+
+  std::atomic<unsigned> refs_;
+  unsigned length_;
+  unsigned capacity_;
+};
+
+/* Prefixed strings in an arena are neither shared nor freed: their refs_
+ * hold arenaBlock and the id of the arena instead of a count.
+ */
+static const unsigned arenaBlock = 0x80000000u;
+
+static inline char* allocateBlock(size_t size, Arena* arena) {
+  return static_cast<char*>(arena ? arena->allocate(size) : malloc(size));
+}
+static inline void markArenaBlock(char* block, Arena* arena) {
+  if (arena)
+    reinterpret_cast<StringPrefix*>(block)->refs_.store(
+        arenaBlock | arena->id(), std::memory_order_relaxed);
+}
+/** \return the id of the arena of the block, or 0 if it is on the heap.
+ */
+static inline unsigned arenaOfBlock(char const* block) {
+  unsigned refs = reinterpret_cast<StringPrefix const*>(block)->refs_.load(
+      std::memory_order_relaxed);
+  return refs & arenaBlock ? refs & ~arenaBlock : 0;
+}
+
 /* Record the length as a prefix.
  */
 static inline char* duplicateAndPrefixStringValue(
     const char* value,
-    unsigned int length)
+    unsigned int length,
+    Arena* arena = 0)
 {
   // Avoid an integer overflow in the call to malloc below by limiting length
   // to a sane value.
-  JSON_ASSERT_MESSAGE(length <= static_cast<unsigned>(Value::maxInt) - sizeof(unsigned) - 1U,
+  JSON_ASSERT_MESSAGE(length <= static_cast<unsigned>(Value::maxInt) - sizeof(StringPrefix) - 1U,
                       "in Json::Value::duplicateAndPrefixStringValue(): "
                       "length too big for prefixing");
-  unsigned actualLength = length + static_cast<unsigned>(sizeof(unsigned)) + 1U;
-  char* newString = static_cast<char*>(malloc(actualLength));
+  unsigned actualLength = length + static_cast<unsigned>(sizeof(StringPrefix)) + 1U;
+  char* newString = allocateBlock(actualLength, arena);
   if (newString == 0) {
     throwRuntimeError(
         "in Json::Value::duplicateAndPrefixStringValue(): "
         "Failed to allocate string value buffer");
   }
-  *reinterpret_cast<unsigned*>(newString) = length;
-  memcpy(newString + sizeof(unsigned), value, length);
+  new (newString) StringPrefix(length);
+  markArenaBlock(newString, arena);
+  memcpy(newString + sizeof(StringPrefix), value, length);
   newString[actualLength - 1U] = 0; // to avoid buffer over-run accidents by users later
   return newString;
 }
@@ -144,18 +189,32 @@ inline static void decodePrefixedString(
     *length = static_cast<unsigned>(strlen(prefixed));
     *value = prefixed;
   } else {
-    *length = *reinterpret_cast<unsigned const*>(prefixed);
-    *value = prefixed + sizeof(unsigned);
+    *length = reinterpret_cast<StringPrefix const*>(prefixed)->length_;
+    *value = prefixed + sizeof(StringPrefix);
   }
 }
+/** Take another reference to a string of duplicateAndPrefixStringValue(), or
+ * copy it to the heap if it is in an arena.
+ */
+static inline char* sharePrefixedStringValue(char* value) {
+  StringPrefix* prefix = reinterpret_cast<StringPrefix*>(value);
+  if (arenaOfBlock(value))
+    return duplicateAndPrefixStringValue(value + sizeof(StringPrefix),
+                                         prefix->length_);
+  prefix->refs_.fetch_add(1, std::memory_order_relaxed);
+  return value;
+}
 /** Free the string duplicated by duplicateStringValue()/duplicateAndPrefixStringValue().
  */
 #if JSONCPP_USING_SECURE_MEMORY
 static inline void releasePrefixedStringValue(char* value) {
-  unsigned length = 0;
-  char const* valueDecoded;
-  decodePrefixedString(true, value, &length, &valueDecoded);
-  size_t const size = sizeof(unsigned) + length + 1U;
+  if (arenaOfBlock(value))
+    return;
+  if (reinterpret_cast<StringPrefix*>(value)->refs_.fetch_sub(
+          1, std::memory_order_acq_rel) != 1)
+    return;
+  unsigned length = reinterpret_cast<StringPrefix*>(value)->capacity_;
+  size_t const size = sizeof(StringPrefix) + length + 1U;
   memset(value, 0, size);
   free(value);
 }
@@ -167,13 +226,263 @@ static inline void releaseStringValue(char* value, unsigned length) {
 }
 #else // !JSONCPP_USING_SECURE_MEMORY
 static inline void releasePrefixedStringValue(char* value) {
-  free(value);
+  if (arenaOfBlock(value))
+    return;
+  if (reinterpret_cast<StringPrefix*>(value)->refs_.fetch_sub(
+          1, std::memory_order_acq_rel) == 1)
+    free(value);
 }
 static inline void releaseStringValue(char* value, unsigned) {
   free(value);
 }
 #endif // JSONCPP_USING_SECURE_MEMORY
 
+/** Source text of a number read with the "lazyNumbers" setting, followed by
+ * its characters like a prefixed string, and its value once decoded.
+ */
+struct NumberText : StringPrefix {
+  explicit NumberText(unsigned length)
+      : StringPrefix(length), decoded_(false), real_(0.0) {}
+
+  mutable std::atomic<bool> decoded_;
+  mutable std::atomic<double> real_;
+};
+
+static inline char* duplicateNumberText(const char* text, unsigned length,
+                                        Arena* arena = 0) {
+  size_t const size = sizeof(NumberText) + length + 1U;
+  char* newText = allocateBlock(size, arena);
+  if (newText == 0) {
+    throwRuntimeError(
+        "in Json::Value::duplicateNumberText(): "
+        "Failed to allocate number text buffer");
+  }
+  new (newText) NumberText(length);
+  markArenaBlock(newText, arena);
+  memcpy(newText + sizeof(NumberText), text, length);
+  newText[size - 1U] = 0;
+  return newText;
+}
+static inline char* shareNumberText(char* text) {
+  if (arenaOfBlock(text))
+    return duplicateNumberText(text + sizeof(NumberText),
+                               reinterpret_cast<NumberText*>(text)->length_);
+  reinterpret_cast<NumberText*>(text)->refs_.fetch_add(
+      1, std::memory_order_relaxed);
+  return text;
+}
+static inline void releaseNumberText(char* text) {
+  NumberText* number = reinterpret_cast<NumberText*>(text);
+  if (arenaOfBlock(text))
+    return;
+  if (number->refs_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+#if JSONCPP_USING_SECURE_MEMORY
+  memset(text, 0, sizeof(NumberText) + number->length_ + 1U);
+#endif
+  free(text);
+}
+/** Decode the text of a real number, once for all the Values sharing it.
+ */
+static double decodeNumberText(char const* text) {
+  NumberText const* number = reinterpret_cast<NumberText const*>(text);
+  if (number->decoded_.load(std::memory_order_acquire))
+    return number->real_.load(std::memory_order_relaxed);
+  // Decode it the way OurReader::decodeDouble() would have.
+  JSONCPP_STRING buffer(text + sizeof(NumberText), number->length_);
+  fixNumericLocaleInput(&buffer[0], &buffer[0] + buffer.size());
+  char format[] = "%lf";
+  double value = 0;
+  sscanf(buffer.c_str(), format, &value);
+  number->real_.store(value, std::memory_order_relaxed);
+  number->decoded_.store(true, std::memory_order_release);
+  return value;
+}
+
+/** Escaped source text of a string read with the "lazyStrings" setting,
+ * followed by its characters like a prefixed string, and the unescaped
+ * string once needed.
+ */
+struct RawString : StringPrefix {
+  RawString(unsigned length, bool escaped, bool verbatim)
+      : StringPrefix(length), escaped_(escaped), verbatim_(verbatim),
+        decoded_(0) {}
+
+  bool escaped_;
+  /// Whether the text is what writers output for the string.
+  bool verbatim_;
+  /// duplicateAndPrefixStringValue() of the unescaped string, or NULL if
+  /// not decoded yet. Unused unless escaped_.
+  mutable std::atomic<char*> decoded_;
+};
+
+// The unescaped string of a RawString is made when first needed, possibly
+// by several threads, so a RawString in an arena must have no escapes.
+static inline char* duplicateRawString(const char* text, unsigned length,
+                                       bool escaped, bool verbatim,
+                                       Arena* arena = 0) {
+  JSON_ASSERT(!(escaped && arena));
+  size_t const size = sizeof(RawString) + length + 1U;
+  char* newText = allocateBlock(size, arena);
+  if (newText == 0) {
+    throwRuntimeError(
+        "in Json::Value::duplicateRawString(): "
+        "Failed to allocate string value buffer");
+  }
+  new (newText) RawString(length, escaped, verbatim);
+  markArenaBlock(newText, arena);
+  memcpy(newText + sizeof(RawString), text, length);
+  newText[size - 1U] = 0;
+  return newText;
+}
+static inline char* shareRawString(char* text) {
+  RawString* raw = reinterpret_cast<RawString*>(text);
+  if (arenaOfBlock(text))
+    return duplicateRawString(text + sizeof(RawString), raw->length_,
+                              raw->escaped_, raw->verbatim_);
+  raw->refs_.fetch_add(1, std::memory_order_relaxed);
+  return text;
+}
+static inline void releaseRawString(char* text) {
+  RawString* raw = reinterpret_cast<RawString*>(text);
+  if (arenaOfBlock(text))
+    return;
+  if (raw->refs_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+  if (char* decoded = raw->decoded_.load(std::memory_order_acquire))
+    releasePrefixedStringValue(decoded);
+#if JSONCPP_USING_SECURE_MEMORY
+  memset(text, 0, sizeof(RawString) + raw->length_ + 1U);
+#endif
+  free(text);
+}
+static inline unsigned decodeHexQuad(char const* hex) {
+  unsigned value = 0;
+  for (int index = 0; index < 4; ++index) {
+    char c = hex[index];
+    value *= 16;
+    if (c >= '0' && c <= '9')
+      value += static_cast<unsigned>(c - '0');
+    else if (c >= 'a' && c <= 'f')
+      value += static_cast<unsigned>(c - 'a' + 10);
+    else
+      value += static_cast<unsigned>(c - 'A' + 10);
+  }
+  return value;
+}
+/** Unescape the text of a string, whose escape sequences the reader has
+ * already checked.
+ */
+static void unescapeRawString(char const* current, char const* end,
+                              JSONCPP_STRING& decoded) {
+  decoded.reserve(static_cast<size_t>(end - current));
+  for (;;) {
+    char const* escape = static_cast<char const*>(
+        memchr(current, '\\', static_cast<size_t>(end - current)));
+    if (!escape) {
+      decoded.append(current, end);
+      return;
+    }
+    decoded.append(current, escape);
+    current = escape + 2;
+    switch (escape[1]) {
+    case 'b':
+      decoded += '\b';
+      break;
+    case 'f':
+      decoded += '\f';
+      break;
+    case 'n':
+      decoded += '\n';
+      break;
+    case 'r':
+      decoded += '\r';
+      break;
+    case 't':
+      decoded += '\t';
+      break;
+    case 'u': {
+      unsigned unicode = decodeHexQuad(current);
+      current += 4;
+      if (unicode >= 0xD800 && unicode <= 0xDBFF) {
+        // surrogate pairs: the second half follows
+        unicode = 0x10000 + ((unicode & 0x3FF) << 10) +
+                  (decodeHexQuad(current + 2) & 0x3FF);
+        current += 6;
+      }
+      decoded += codePointToUTF8(unicode);
+    } break;
+    default: // '"', '/' and '\\' stand for themselves.
+      decoded += escape[1];
+    }
+  }
+}
+/** Unescape a RawString, once for all the Values sharing it.
+ */
+static void decodeRawString(char const* text, unsigned* length,
+                            char const** value) {
+  RawString const* raw = reinterpret_cast<RawString const*>(text);
+  if (!raw->escaped_) {
+    *length = raw->length_;
+    *value = text + sizeof(RawString);
+    return;
+  }
+  char* decoded = raw->decoded_.load(std::memory_order_acquire);
+  if (!decoded) {
+    JSONCPP_STRING unescaped;
+    unescapeRawString(text + sizeof(RawString),
+                      text + sizeof(RawString) + raw->length_, unescaped);
+    char* fresh = duplicateAndPrefixStringValue(
+        unescaped.data(), static_cast<unsigned>(unescaped.length()));
+    if (raw->decoded_.compare_exchange_strong(decoded, fresh,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire))
+      decoded = fresh;
+    else
+      releasePrefixedStringValue(fresh); // another thread was first
+  }
+  decodePrefixedString(true, decoded, length, value);
+}
+
+/** Take another reference to an array or object payload, or copy it if it is
+ * not shareable or in an arena.
+ */
+template <typename Payload> static inline Payload* sharePayload(Payload* payload) {
+  if (!payload->shareable_ || payload->arena_)
+    return new Payload(*payload);
+  payload->refs_.fetch_add(1, std::memory_order_relaxed);
+  return payload;
+}
+template <typename Payload> static inline void releasePayload(Payload* payload) {
+  if (payload->arena_)
+    return;
+  if (payload->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    delete payload;
+}
+/** Allocate an object in arena if not NULL, or else on the heap.
+ */
+template <typename T, typename... Args>
+static inline T* createIn(Arena* arena, Args&&... args) {
+  if (!arena)
+    return new T(std::forward<Args>(args)...);
+  return new (arena->allocate(sizeof(T))) T(std::forward<Args>(args)...);
+}
+template <typename T> static inline void destroyIn(Arena* arena, T* object) {
+  if (!arena)
+    delete object;
+  else if (object)
+    object->~T();
+}
+/** Replace a shared payload by a copy of its own.
+ */
+template <typename Payload> static inline void detachPayload(Payload*& payload) {
+  if (payload->refs_.load(std::memory_order_acquire) == 1)
+    return;
+  Payload* copy = new Payload(*payload);
+  releasePayload(payload);
+  payload = copy;
+}
+
 } // namespace Json
 
 // //////////////////////////////////////////////////////////////////
@@ -243,6 +552,131 @@ void Value::CommentInfo::setComment(const char* text, size_t len) {
   comment_ = duplicateStringValue(text, len);
 }
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::Extra
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+/*! \internal Comments and source offsets of a Value.
+ *
+ * Records live in process-wide tables, and a Value only keeps the handle of
+ * its record. Each thread acquires handles from one of several shards, each
+ * with a lock of its own, so that threads parsing documents at once do not
+ * wait for each other; the top bits of a handle tell its shard. Chunk k of a
+ * shard holds (chunkBase << k) records, so that records never move and a few
+ * chunks cover every handle. Looking a record up needs no lock, since a
+ * chunk is created before any of its handles is handed out. Once all the
+ * handles of a shard are released, it frees its larger chunks.
+ */
+struct Value::Extra {
+  Extra() : comments_(0), start_(0), limit_(0) {}
+
+  void clear() {
+    delete[] comments_;
+    comments_ = 0;
+    start_ = 0;
+    limit_ = 0;
+  }
+
+  static UInt acquire();
+  static void release(UInt handle);
+  static Extra& at(UInt handle);
+
+  CommentInfo* comments_;
+  // [start, limit) byte offsets in the source JSON text from which the Value
+  // was extracted.
+  ptrdiff_t start_;
+  ptrdiff_t limit_;
+
+private:
+  static const UInt chunkBase = 64;
+  static const unsigned maxChunks = 32;
+  // Chunks kept by a shard with no handles out.
+  static const unsigned keptChunks = 4;
+  static const unsigned shardBits = 4;
+  static const unsigned shardCount = 1U << shardBits;
+  static const UInt maxIndex = UInt(-1) >> shardBits;
+
+  struct Shard {
+    Shard() : next_(0), live_(0), free_() {
+      for (unsigned k = 0; k < maxChunks; ++k)
+        chunks_[k] = 0;
+    }
+    std::mutex mutex_;
+    Extra* chunks_[maxChunks];
+    UInt next_;
+    UInt live_;
+    std::vector<UInt> free_;
+  };
+
+  // Never destroyed, so that static Values can outlive them.
+  static Shard* shards() {
+    static Shard* instances = new Shard[shardCount];
+    return instances;
+  }
+
+  // index is the handle within its shard, from 1.
+  static void locate(UInt index, unsigned* chunk, UInt* offset) {
+    --index;
+    UInt n = index / chunkBase + 1;
+    unsigned k = 0;
+    while (n >>= 1)
+      ++k;
+    *chunk = k;
+    *offset = index - chunkBase * ((UInt(1) << k) - 1);
+  }
+};
+
+UInt Value::Extra::acquire() {
+  unsigned s = static_cast<unsigned>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()) % shardCount);
+  Shard& shard = shards()[s];
+  std::lock_guard<std::mutex> lock(shard.mutex_);
+  UInt index;
+  if (!shard.free_.empty()) {
+    index = shard.free_.back();
+    shard.free_.pop_back();
+  } else {
+    if (shard.next_ == maxIndex)
+      throwRuntimeError("in Json::Value: too many comments and offsets");
+    index = ++shard.next_;
+    unsigned chunk;
+    UInt offset;
+    locate(index, &chunk, &offset);
+    if (!shard.chunks_[chunk])
+      shard.chunks_[chunk] = new Extra[chunkBase << chunk];
+  }
+  ++shard.live_;
+  return (UInt(s) << (32 - shardBits)) | index;
+}
+
+void Value::Extra::release(UInt handle) {
+  at(handle).clear();
+  Shard& shard = shards()[handle >> (32 - shardBits)];
+  std::lock_guard<std::mutex> lock(shard.mutex_);
+  if (--shard.live_) {
+    shard.free_.push_back(handle & maxIndex);
+    return;
+  }
+  // No record of the shard is in use: start it over.
+  for (unsigned k = keptChunks; k < maxChunks; ++k) {
+    delete[] shard.chunks_[k];
+    shard.chunks_[k] = 0;
+  }
+  shard.next_ = 0;
+  std::vector<UInt>().swap(shard.free_);
+}
+
+Value::Extra& Value::Extra::at(UInt handle) {
+  unsigned chunk;
+  UInt offset;
+  locate(handle & maxIndex, &chunk, &offset);
+  return shards()[handle >> (32 - shardBits)].chunks_[chunk][offset];
+}
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -275,7 +709,7 @@ Value::CZString::CZString(const CZString& other) {
 }
 
 #if JSON_HAS_RVALUE_REFERENCES
-Value::CZString::CZString(CZString&& other)
+Value::CZString::CZString(CZString&& other) JSONCPP_NOEXCEPT
   : cstr_(other.cstr_), index_(other.index_) {
   other.cstr_ = nullptr;
 }
@@ -303,6 +737,8 @@ bool Value::CZString::operator<(const CZString& other) const {
   // Assume both are strings.
   unsigned this_len = this->storage_.length_;
   unsigned other_len = other.storage_.length_;
+  // Interned names are shared, so equal pointers are common.
+  if (this->cstr_ == other.cstr_) return (this_len < other_len);
   unsigned min_len = std::min<unsigned>(this_len, other_len);
   JSON_ASSERT(this->cstr_ && other.cstr_);
   int comp = memcmp(this->cstr_, other.cstr_, min_len);
@@ -318,6 +754,7 @@ bool Value::CZString::operator==(const CZString& other) const {
   unsigned this_len = this->storage_.length_;
   unsigned other_len = other.storage_.length_;
   if (this_len != other_len) return false;
+  if (this->cstr_ == other.cstr_) return true;
   JSON_ASSERT(this->cstr_ && other.cstr_);
   int comp = memcmp(this->cstr_, other.cstr_, this_len);
   return comp == 0;
@@ -330,6 +767,903 @@ const char* Value::CZString::data() const { return cstr_; }
 unsigned Value::CZString::length() const { return storage_.length_; }
 bool Value::CZString::isStaticString() const { return storage_.policy_ == noDuplication; }
 
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::ArrayValues
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+struct Value::ArrayValues::Packed {
+  explicit Packed(ValueType type) : type_(type) {}
+
+  ArrayIndex size() const {
+    return ArrayIndex(type_ == intValue ? ints_.size() : reals_.size());
+  }
+
+  ValueType type_; // intValue or realValue
+  std::vector<LargestInt> ints_;
+  std::vector<double> reals_;
+};
+
+namespace {
+// Shorter arrays take no less room packed.
+const ArrayIndex minPackedSize = 16;
+
+// Taken to box packed numbers, which happens once per array at most.
+std::mutex& boxingMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+} // namespace
+
+Value::ArrayValues::ArrayValues(const ArrayValues& other)
+    : std::vector<Value, ArenaAllocator<Value> >(
+          other.packed_ ? std::vector<Value, ArenaAllocator<Value> >()
+                        : static_cast<const std::vector<
+                              Value, ArenaAllocator<Value> >&>(other)),
+      SharedPayload(other),
+      packed_(other.packed_ ? new Packed(*other.packed_) : 0), boxed_(false) {}
+
+Value::ArrayValues::~ArrayValues() { delete packed_; }
+
+ArrayIndex Value::ArrayValues::count() const {
+  return packed_ ? packed_->size() : ArrayIndex(size());
+}
+
+const Value::ArrayValues& Value::ArrayValues::boxed() const {
+  if (!packed_ || boxed_.load(std::memory_order_acquire))
+    return *this;
+  std::lock_guard<std::mutex> lock(boxingMutex());
+  if (!boxed_.load(std::memory_order_relaxed)) {
+    ArrayValues& elements = const_cast<ArrayValues&>(*this);
+    elements.reserve(packed_->size());
+    if (packed_->type_ == intValue) {
+      for (size_t i = 0; i < packed_->ints_.size(); ++i)
+        elements.push_back(Value(packed_->ints_[i]));
+    } else {
+      for (size_t i = 0; i < packed_->reals_.size(); ++i)
+        elements.push_back(Value(packed_->reals_[i]));
+    }
+    boxed_.store(true, std::memory_order_release);
+  }
+  return *this;
+}
+
+bool Value::ArrayValues::sameElements(const ArrayValues& other) const {
+  if (packed_ && other.packed_ && packed_->type_ == other.packed_->type_)
+    return packed_->ints_ == other.packed_->ints_ &&
+           packed_->reals_ == other.packed_->reals_;
+  const std::vector<Value, ArenaAllocator<Value> >& elements = boxed();
+  return elements == other.boxed();
+}
+
+void Value::ArrayValues::unpack() {
+  if (!packed_)
+    return;
+  boxed();
+  dropPacked();
+}
+
+void Value::ArrayValues::dropPacked() {
+  delete packed_;
+  packed_ = 0;
+  boxed_.store(false, std::memory_order_relaxed);
+}
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Value::ObjectValues
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+namespace {
+struct MemberKeyLess {
+  template <typename Member, typename Key>
+  bool operator()(const Member& member, const Key& key) const {
+    return member.first < key;
+  }
+};
+
+// 32-bit FNV-1a.
+inline UInt hashKey(char const* key, unsigned length) {
+  UInt hash = 2166136261u;
+  for (unsigned i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+} // namespace
+
+/*! \internal Open-addressing hash table over the nodes of the tree, with
+ * linear probing. Tree iterators remain valid until their member is erased,
+ * so the index only changes on insertion and erasure.
+ */
+struct Value::ObjectValues::Index {
+  struct Slot {
+    Slot() : node(), hash(0), used(false) {}
+    Tree::iterator node;
+    UInt hash;
+    bool used;
+  };
+
+  explicit Index(Tree& tree);
+
+  /// \return tree.end() if there is no such member.
+  Tree::iterator find(const CZString& key, Tree& tree) const;
+  Tree::iterator find(const CZString& key, UInt hash, Tree& tree) const;
+  void insert(const Tree::iterator& node);
+  void erase(const Tree::iterator& node);
+  /// Forget all nodes, keeping the capacity.
+  void clear();
+  /// Make room for count nodes.
+  void reserve(size_t count);
+  void shrinkToFit();
+  size_t byteSize() const {
+    return sizeof(Index) + slots_.capacity() * sizeof(Slot);
+  }
+
+private:
+  /// \return the smallest capacity for count nodes.
+  static size_t capacityFor(size_t count);
+  size_t home(UInt hash) const { return hash & (slots_.size() - 1); }
+  void place(const Slot& slot);
+  void rehash(size_t capacity);
+
+  // In the arena of the tree, if any.
+  typedef std::vector<Slot, ArenaAllocator<Slot> > Slots;
+
+  Slots slots_; // size is a power of 2, at most half full
+  size_t count_;
+};
+
+Value::ObjectValues::Index::Index(Tree& tree)
+    : slots_(capacityFor(tree.size()), Slot(),
+             ArenaAllocator<Slot>(tree.get_allocator())),
+      count_(0) {
+  for (Tree::iterator it = tree.begin(); it != tree.end(); ++it)
+    insert(it);
+}
+
+size_t Value::ObjectValues::Index::capacityFor(size_t count) {
+  size_t capacity = 2 * hashIndexThreshold;
+  while (capacity < 2 * count)
+    capacity *= 2;
+  return capacity;
+}
+
+Value::ObjectValues::Tree::iterator
+Value::ObjectValues::Index::find(const CZString& key, Tree& tree) const {
+  return find(key, hashKey(key.data(), key.length()), tree);
+}
+
+Value::ObjectValues::Tree::iterator
+Value::ObjectValues::Index::find(const CZString& key, UInt hash,
+                                 Tree& tree) const {
+  size_t mask = slots_.size() - 1;
+  for (size_t i = home(hash); slots_[i].used; i = (i + 1) & mask) {
+    if (slots_[i].hash == hash && slots_[i].node->first == key)
+      return slots_[i].node;
+  }
+  return tree.end();
+}
+
+void Value::ObjectValues::Index::insert(const Tree::iterator& node) {
+  if (2 * (count_ + 1) > slots_.size())
+    rehash(2 * slots_.size());
+  Slot slot;
+  slot.node = node;
+  slot.hash = hashKey(node->first.data(), node->first.length());
+  slot.used = true;
+  place(slot);
+  ++count_;
+}
+
+void Value::ObjectValues::Index::clear() {
+  std::fill(slots_.begin(), slots_.end(), Slot());
+  count_ = 0;
+}
+
+void Value::ObjectValues::Index::reserve(size_t count) {
+  size_t capacity = capacityFor(count);
+  if (capacity > slots_.size())
+    rehash(capacity);
+}
+
+void Value::ObjectValues::Index::shrinkToFit() {
+  size_t capacity = capacityFor(count_);
+  if (capacity < slots_.size())
+    rehash(capacity);
+}
+
+void Value::ObjectValues::Index::rehash(size_t capacity) {
+  Slots old(capacity, Slot(), slots_.get_allocator());
+  old.swap(slots_);
+  for (size_t i = 0; i < old.size(); ++i) {
+    if (old[i].used)
+      place(old[i]);
+  }
+}
+
+void Value::ObjectValues::Index::place(const Slot& slot) {
+  size_t mask = slots_.size() - 1;
+  size_t i = home(slot.hash);
+  while (slots_[i].used)
+    i = (i + 1) & mask;
+  slots_[i] = slot;
+}
+
+void Value::ObjectValues::Index::erase(const Tree::iterator& node) {
+  size_t mask = slots_.size() - 1;
+  size_t i = home(hashKey(node->first.data(), node->first.length()));
+  while (!(slots_[i].used && slots_[i].node == node))
+    i = (i + 1) & mask;
+  // Shift back the following slots of the cluster, unless their home lies
+  // cyclically in (i, j], so that no probe sequence crosses an empty slot.
+  for (size_t j = (i + 1) & mask; slots_[j].used; j = (j + 1) & mask) {
+    size_t k = home(slots_[j].hash);
+    if (j > i ? (k <= i || k > j) : (k <= i && k > j)) {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+  slots_[i] = Slot();
+  --count_;
+}
+
+/*! \internal Names of the members of objects read one after the other with
+ * the same members, as the records of an array usually are. Immutable once
+ * made, and only ever on the heap.
+ */
+struct Value::Shape {
+  explicit Shape(size_t count) : refs_(1) { names_.reserve(count); }
+
+  std::atomic<unsigned> refs_;
+  std::vector<CZString> names_; // in order
+};
+
+void Value::releaseShape(Shape* shape) {
+  if (shape && shape->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    delete shape;
+}
+
+const size_t Value::ObjectValues::smallObjectLimit;
+const size_t Value::ObjectValues::hashIndexThreshold;
+
+Value::ObjectValues::ObjectValues(Arena* arena)
+    : SharedPayload(arena), flat_(ArenaAllocator<Member>(arena)), tree_(0),
+      index_(0), shape_(0), values_(0) {}
+
+// Copies are made on the heap, as are their members and names.
+Value::ObjectValues::ObjectValues(const ObjectValues& other)
+    : SharedPayload(), flat_(other.flat_), tree_(other.tree_ ? new Tree(*other.tree_) : 0),
+      index_(other.index_ ? new Index(*tree_) : 0), shape_(other.shape_),
+      values_(0) {
+  if (shape_) {
+    shape_->refs_.fetch_add(1, std::memory_order_relaxed);
+    size_t count = shape_->names_.size();
+    values_ = new Value[count];
+    std::copy(other.values_, other.values_ + count, values_);
+  }
+}
+
+Value::ObjectValues::~ObjectValues() {
+  dropShape();
+  destroyIn(arena_, index_);
+  destroyIn(arena_, tree_);
+}
+
+size_t Value::ObjectValues::size() const {
+  if (shape_)
+    return shape_->names_.size();
+  return tree_ ? tree_->size() : flat_.size();
+}
+
+bool Value::ObjectValues::empty() const {
+  if (shape_)
+    return false;
+  return tree_ ? tree_->empty() : flat_.empty();
+}
+
+void Value::ObjectValues::clear() {
+  dropShape();
+  destroyIn(arena_, index_);
+  index_ = 0;
+  destroyIn(arena_, tree_);
+  tree_ = 0;
+  flat_.clear();
+}
+
+void Value::ObjectValues::reset() {
+  dropShape();
+  if (index_)
+    index_->clear();
+  if (tree_)
+    tree_->clear();
+  flat_.clear();
+}
+
+Value::ObjectValues::iterator Value::ObjectValues::begin() {
+  if (shape_)
+    return iterator(&shape_->names_[0], values_);
+  if (tree_)
+    return iterator(tree_->begin());
+  return iterator(flat_.empty() ? 0 : &flat_[0]);
+}
+
+Value::ObjectValues::iterator Value::ObjectValues::end() {
+  if (shape_) {
+    size_t count = shape_->names_.size();
+    return iterator(&shape_->names_[0] + count, values_ + count);
+  }
+  if (tree_)
+    return iterator(tree_->end());
+  return iterator(flat_.empty() ? 0 : &flat_[0] + flat_.size());
+}
+
+Value::ObjectValues::iterator
+Value::ObjectValues::find(const CZString& key) {
+  if (shape_) {
+    std::vector<CZString>::const_iterator name = std::lower_bound(
+        shape_->names_.begin(), shape_->names_.end(), key);
+    if (name == shape_->names_.end() || !(*name == key))
+      return end();
+    size_t position = static_cast<size_t>(name - shape_->names_.begin());
+    return iterator(&*name, values_ + position);
+  }
+  if (index_)
+    return iterator(index_->find(key, *tree_));
+  if (tree_)
+    return iterator(tree_->find(key));
+  Flat::iterator it =
+      std::lower_bound(flat_.begin(), flat_.end(), key, MemberKeyLess());
+  if (it == flat_.end() || !(it->first == key))
+    return end();
+  return iterator(&*it);
+}
+
+Value::ObjectValues::iterator
+Value::ObjectValues::find(const CZString& key, UInt hash) {
+  if (index_)
+    return iterator(index_->find(key, hash, *tree_));
+  return find(key);
+}
+
+Value& Value::ObjectValues::resolve(const CZString& key) {
+  Value empty;
+  return place(key, empty, false);
+}
+
+Value& Value::ObjectValues::assign(const CZString& key, Value& value) {
+  return place(key, value, true);
+}
+
+// Find the member named key, or insert it with the payload of value. An
+// existing member also takes it if overwrite.
+Value& Value::ObjectValues::place(const CZString& key, Value& source,
+                                  bool overwrite) {
+  // source may be a member of this object, which the insertion moves or
+  // frees: take its payload first.
+  Value value;
+  value.swap(source);
+  if (shape_) {
+    iterator it = find(key);
+    if (it != end()) {
+      if (overwrite)
+        it.value().swap(value);
+      return it.value();
+    }
+    unshape();
+  }
+  if (!tree_) {
+    Flat::iterator it =
+        std::lower_bound(flat_.begin(), flat_.end(), key, MemberKeyLess());
+    if (it != flat_.end() && it->first == key) {
+      if (overwrite)
+        it->second.swap(value);
+      return it->second;
+    }
+    if (flat_.size() < smallObjectLimit) {
+      it = flat_.insert(it, Member(storedKey(key), Value()));
+      it->second.swap(value);
+      return it->second;
+    }
+    promote();
+  }
+  Tree::iterator it;
+  if (index_) {
+    it = index_->find(key, *tree_);
+    if (it == tree_->end()) {
+      it = tree_->emplace(storedKey(key), Value()).first;
+      index_->insert(it);
+      (*it).second.swap(value);
+      return (*it).second;
+    }
+  } else {
+    it = tree_->lower_bound(key);
+    if (it == tree_->end() || !((*it).first == key)) {
+      it = tree_->emplace_hint(it, storedKey(key), Value());
+      if (tree_->size() >= hashIndexThreshold)
+        index_ = createIn<Index>(arena_, *tree_);
+      (*it).second.swap(value);
+      return (*it).second;
+    }
+  }
+  if (overwrite)
+    (*it).second.swap(value);
+  return (*it).second;
+}
+
+void Value::ObjectValues::reserve(size_t count) {
+  if (shape_)
+    unshape();
+  if (!tree_) {
+    if (count <= smallObjectLimit) {
+      flat_.reserve(count);
+      return;
+    }
+    promote();
+  }
+  if (count >= hashIndexThreshold) {
+    if (!index_)
+      index_ = createIn<Index>(arena_, *tree_);
+    index_->reserve(count);
+  }
+}
+
+void Value::ObjectValues::shrinkToFit() {
+  if (index_)
+    index_->shrinkToFit();
+  if (!tree_)
+    flat_.shrink_to_fit();
+}
+
+Value::ObjectValues::iterator Value::ObjectValues::erase(iterator it) {
+  if (shape_) {
+    size_t position = static_cast<size_t>(it.value_ - values_);
+    unshape();
+    it = begin();
+    while (position--)
+      ++it;
+  }
+  if (index_)
+    index_->erase(it.node_);
+  if (tree_) {
+    tree_->erase(it.node_++);
+    return it;
+  }
+  size_t position = static_cast<size_t>(it.member_ - &flat_[0]);
+  flat_.erase(flat_.begin() + position);
+  return iterator(flat_.empty() ? 0 : &flat_[0] + position);
+}
+
+bool Value::ObjectValues::operator==(const ObjectValues& other) const {
+  if (size() != other.size())
+    return false;
+  if (shape_ && shape_ == other.shape_)
+    return std::equal(values_, values_ + size(), other.values_);
+  ObjectValues& self = const_cast<ObjectValues&>(*this);
+  ObjectValues& that = const_cast<ObjectValues&>(other);
+  for (iterator it = self.begin(), otherIt = that.begin(); it != self.end();
+       ++it, ++otherIt) {
+    if (!(it.key() == otherIt.key()) || it.value() != otherIt.value())
+      return false;
+  }
+  return true;
+}
+
+bool Value::ObjectValues::operator<(const ObjectValues& other) const {
+  ObjectValues& self = const_cast<ObjectValues&>(*this);
+  ObjectValues& that = const_cast<ObjectValues&>(other);
+  iterator it = self.begin();
+  iterator otherIt = that.begin();
+  for (; it != self.end() && otherIt != that.end(); ++it, ++otherIt) {
+    if (it.key() < otherIt.key())
+      return true;
+    if (otherIt.key() < it.key())
+      return false;
+    if (it.value() < otherIt.value())
+      return true;
+    if (otherIt.value() < it.value())
+      return false;
+  }
+  return it == self.end() && otherIt != that.end();
+}
+
+Value::CZString Value::ObjectValues::storedKey(const CZString& key) const {
+  // Names are copied into the arena of the object, if any, and to the heap
+  // when copied out of it.
+  if (!arena_ || key.isStaticString())
+    return key;
+  char* name = static_cast<char*>(arena_->allocate(key.length() + 1U));
+  memcpy(name, key.data(), key.length());
+  name[key.length()] = 0;
+  return CZString(name, key.length(), CZString::duplicateOnCopy);
+}
+
+void Value::ObjectValues::promote() {
+  // Members are already sorted, so each insertion is at the end.
+  Tree* tree = createIn<Tree>(arena_, Tree::allocator_type(arena_));
+  for (Flat::iterator it = flat_.begin(); it != flat_.end(); ++it) {
+    Tree::iterator node =
+        tree->emplace_hint(tree->end(), std::move(it->first), Value());
+    node->second.swap(it->second);
+  }
+  Flat(flat_.get_allocator()).swap(flat_);
+  tree_ = tree;
+}
+
+void Value::ObjectValues::share(Shape*& last, UInt& candidate) {
+  if (shape_) {
+    // Read over an object already shaped.
+    if (shape_ != last) {
+      releaseShape(last);
+      last = shape_;
+      last->refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return;
+  }
+  size_t count = size();
+  bool same = last && last->names_.size() == count;
+  if (same) {
+    std::vector<CZString>::const_iterator name = last->names_.begin();
+    for (iterator it = begin(); same && it != end(); ++it, ++name)
+      same = *name == it.key();
+  }
+  Shape* shape;
+  if (same) {
+    shape = last;
+    shape->refs_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    // Objects whose names differ from the object before, as alternating
+    // ones, are not worth a shape of their own.
+    UInt names = static_cast<UInt>(count);
+    for (iterator it = begin(); it != end(); ++it)
+      names = names * 31 + hashKey(it.key().data(), it.key().length());
+    names = names ? names : 1;
+    if (names != candidate) {
+      candidate = names;
+      return;
+    }
+    candidate = 0;
+    shape = new Shape(count);
+    for (iterator it = begin(); it != end(); ++it)
+      shape->names_.push_back(it.key());
+    releaseShape(last);
+    last = shape;
+    shape->refs_.fetch_add(1, std::memory_order_relaxed);
+  }
+  Value* values = new Value[count];
+  Value* value = values;
+  for (iterator it = begin(); it != end(); ++it)
+    (value++)->swap(it.value());
+  clear();
+  Flat(flat_.get_allocator()).swap(flat_);
+  shape_ = shape;
+  values_ = values;
+}
+
+void Value::ObjectValues::unshape() {
+  Shape* shape = shape_;
+  Value* values = values_;
+  shape_ = 0;
+  values_ = 0;
+  size_t count = shape->names_.size();
+  if (count > smallObjectLimit) {
+    tree_ = createIn<Tree>(arena_, Tree::allocator_type(arena_));
+    for (size_t i = 0; i < count; ++i)
+      tree_->emplace_hint(tree_->end(), shape->names_[i], Value())
+          ->second.swap(values[i]);
+    if (count >= hashIndexThreshold)
+      index_ = createIn<Index>(arena_, *tree_);
+  } else {
+    flat_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      flat_.push_back(Member(shape->names_[i], Value()));
+      flat_.back().second.swap(values[i]);
+    }
+  }
+  delete[] values;
+  releaseShape(shape);
+}
+
+void Value::ObjectValues::dropShape() {
+  delete[] values_;
+  values_ = 0;
+  releaseShape(shape_);
+  shape_ = 0;
+}
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class KeyPool
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+namespace {
+// Names are copied into chunks that are never freed, and found through an
+// open-addressing hash table of pointers to them.
+struct KeyPoolTable {
+  struct Slot {
+    char const* name;
+    unsigned length;
+    UInt hash;
+  };
+  static const size_t chunkSize = 64 * 1024;
+
+  KeyPoolTable()
+      : slots_(1024), count_(0), bytes_(0), chunk_(0), chunkLeft_(0) {
+    for (size_t i = 0; i < slots_.size(); ++i)
+      slots_[i].name = 0;
+  }
+
+  char const* intern(char const* begin, unsigned length) {
+    UInt hash = hashKey(begin, length);
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t mask = slots_.size() - 1;
+    size_t i = hash & mask;
+    for (; slots_[i].name; i = (i + 1) & mask) {
+      if (slots_[i].hash == hash && slots_[i].length == length &&
+          memcmp(slots_[i].name, begin, length) == 0)
+        return slots_[i].name;
+    }
+    if (count_ >= KeyPool::maxSize ||
+        bytes_ + length + 1 > KeyPool::maxBytes)
+      return 0;
+    char* name = allocate(length + 1);
+    memcpy(name, begin, length);
+    name[length] = 0;
+    slots_[i].name = name;
+    slots_[i].length = length;
+    slots_[i].hash = hash;
+    if (2 * ++count_ > slots_.size())
+      grow();
+    return name;
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+  }
+
+private:
+  // size is at most KeyPool::maxNameLength + 1, well below chunkSize.
+  char* allocate(size_t size) {
+    if (size > chunkLeft_) {
+      chunk_ = static_cast<char*>(malloc(chunkSize));
+      chunkLeft_ = chunkSize;
+    }
+    if (!chunk_)
+      throwRuntimeError("in Json::KeyPool::intern(): out of memory");
+    char* result = chunk_;
+    chunk_ += size;
+    chunkLeft_ -= size;
+    bytes_ += size;
+    return result;
+  }
+
+  void grow() {
+    std::vector<Slot> old(2 * slots_.size());
+    for (size_t i = 0; i < old.size(); ++i)
+      old[i].name = 0;
+    old.swap(slots_);
+    size_t mask = slots_.size() - 1;
+    for (size_t i = 0; i < old.size(); ++i) {
+      if (!old[i].name)
+        continue;
+      size_t j = old[i].hash & mask;
+      while (slots_[j].name)
+        j = (j + 1) & mask;
+      slots_[j] = old[i];
+    }
+  }
+
+  std::mutex mutex_;
+  std::vector<Slot> slots_;
+  size_t count_;
+  size_t bytes_; // taken by the names
+  char* chunk_;
+  size_t chunkLeft_;
+};
+
+// Never destroyed, since interned names may outlive static objects.
+KeyPoolTable& keyPoolTable() {
+  static KeyPoolTable* instance = new KeyPoolTable();
+  return *instance;
+}
+
+std::atomic<bool> keyPoolEnabled(false);
+} // namespace
+
+const size_t KeyPool::maxSize;
+const size_t KeyPool::maxNameLength;
+const size_t KeyPool::maxBytes;
+
+char const* KeyPool::intern(char const* begin, char const* end) {
+  if (static_cast<size_t>(end - begin) > maxNameLength)
+    return 0;
+  unsigned length = static_cast<unsigned>(end - begin);
+  if (memchr(begin, 0, length))
+    return 0;
+  return keyPoolTable().intern(begin, length);
+}
+
+void KeyPool::setEnabled(bool enabled) { keyPoolEnabled = enabled; }
+
+bool KeyPool::isEnabled() { return keyPoolEnabled; }
+
+size_t KeyPool::size() { return keyPoolTable().size(); }
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Key
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+Key::Key(const char* name) { init(name, name + strlen(name)); }
+
+Key::Key(const char* begin, const char* end) { init(begin, end); }
+
+Key::Key(const JSONCPP_STRING& name) {
+  init(name.data(), name.data() + name.length());
+}
+
+Key::Key(const Key& other)
+    : name_(other.name_), length_(other.length_), hash_(other.hash_),
+      interned_(other.interned_), storage_(other.storage_) {
+  if (!interned_)
+    name_ = storage_.c_str();
+}
+
+Key& Key::operator=(const Key& other) {
+  Key copy(other);
+  std::swap(name_, copy.name_);
+  std::swap(length_, copy.length_);
+  std::swap(hash_, copy.hash_);
+  std::swap(interned_, copy.interned_);
+  storage_.swap(copy.storage_);
+  if (!interned_)
+    name_ = storage_.c_str();
+  return *this;
+}
+
+void Key::init(const char* begin, const char* end) {
+  JSON_ASSERT_MESSAGE(end - begin < (1 << 30),
+                      "in Json::Key::Key(): name too long");
+  length_ = static_cast<unsigned>(end - begin);
+  hash_ = hashKey(begin, length_);
+  name_ = KeyPool::isEnabled() ? KeyPool::intern(begin, end) : 0;
+  interned_ = name_ != 0;
+  if (!interned_) {
+    storage_.assign(begin, end);
+    name_ = storage_.c_str();
+  }
+}
+
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// class Arena
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+// //////////////////////////////////////////////////////////////////
+
+// Header of a chunk, followed by its bytes.
+struct Arena::Chunk {
+  Chunk* next_;
+  size_t size_;
+
+  static size_t headerSize() {
+    return (sizeof(Chunk) + alignment - 1) & ~(alignment - 1);
+  }
+  char* data() { return reinterpret_cast<char*>(this) + headerSize(); }
+};
+
+namespace {
+// Arenas alive, by id, so that a Value names its arena in a few bits. Ids
+// are handed out under a lock; looking one up needs none, since the values
+// of an arena are only made once it has its id.
+struct ArenaTable {
+  ArenaTable() {
+    for (unsigned id = 0; id <= Arena::maxArenas; ++id)
+      arenas_[id] = 0;
+  }
+  std::mutex mutex_;
+  std::atomic<Arena*> arenas_[Arena::maxArenas + 1];
+};
+
+// Never destroyed, so that static Arenas can outlive it.
+ArenaTable& arenaTable() {
+  static ArenaTable* instance = new ArenaTable();
+  return *instance;
+}
+} // namespace
+
+const unsigned Arena::maxArenas;
+const size_t Arena::alignment;
+
+Arena::Arena(size_t chunkSize)
+    : chunks_(0), next_(0), limit_(0), chunkSize_(chunkSize), used_(0),
+      id_(0), extras_() {
+  ArenaTable& table = arenaTable();
+  std::lock_guard<std::mutex> lock(table.mutex_);
+  for (unsigned id = 1; id <= maxArenas; ++id) {
+    if (!table.arenas_[id].load(std::memory_order_relaxed)) {
+      table.arenas_[id].store(this, std::memory_order_relaxed);
+      id_ = id;
+      return;
+    }
+  }
+  throwRuntimeError("in Json::Arena::Arena(): too many arenas");
+}
+
+Arena::~Arena() {
+  release();
+  free(chunks_);
+  ArenaTable& table = arenaTable();
+  std::lock_guard<std::mutex> lock(table.mutex_);
+  table.arenas_[id_].store(0, std::memory_order_relaxed);
+}
+
+void* Arena::allocateChunk(size_t size) {
+  size_t capacity = std::max(chunkSize_, size);
+  Chunk* chunk = static_cast<Chunk*>(malloc(Chunk::headerSize() + capacity));
+  if (chunk == 0) {
+    throwRuntimeError("in Json::Arena::allocate(): "
+                      "Failed to allocate a chunk");
+  }
+  chunk->size_ = capacity;
+  used_ += size;
+  if (capacity > chunkSize_ && chunks_) {
+    // A large block gets a chunk of its own, behind the current one, which
+    // keeps serving small blocks.
+    chunk->next_ = chunks_->next_;
+    chunks_->next_ = chunk;
+    return chunk->data();
+  }
+  chunk->next_ = chunks_;
+  chunks_ = chunk;
+  next_ = chunk->data() + size;
+  limit_ = chunk->data() + capacity;
+  return chunk->data();
+}
+
+void Arena::release() {
+  for (size_t i = 0; i < extras_.size(); ++i)
+    Value::Extra::release(extras_[i]);
+  extras_.clear();
+  Chunk* kept = 0;
+  while (chunks_) {
+    Chunk* next = chunks_->next_;
+    if (!kept && chunks_->size_ == chunkSize_)
+      kept = chunks_;
+    else
+      free(chunks_);
+    chunks_ = next;
+  }
+  chunks_ = kept;
+  if (kept) {
+    kept->next_ = 0;
+    next_ = kept->data();
+    limit_ = next_ + kept->size_;
+  } else {
+    next_ = limit_ = 0;
+  }
+  used_ = 0;
+}
+
+Arena* Arena::byId(unsigned id) {
+  return arenaTable().arenas_[id].load(std::memory_order_relaxed);
+}
+
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
 // //////////////////////////////////////////////////////////////////
@@ -342,7 +1676,9 @@ bool Value::CZString::isStaticString() const { return storage_.policy_ == noDupl
  * memset( this, 0, sizeof(Value) )
  * This optimization is used in ValueInternalMap fast allocator.
  */
-Value::Value(ValueType vtype) {
+Value::Value(ValueType vtype) : Value(vtype, static_cast<Arena*>(0)) {}
+
+Value::Value(ValueType vtype, Arena* arena) {
   static char const emptyString[] = "";
   initBasic(vtype);
   switch (vtype) {
@@ -360,8 +1696,10 @@ Value::Value(ValueType vtype) {
     value_.string_ = const_cast<char*>(static_cast<char const*>(emptyString));
     break;
   case arrayValue:
+    value_.array_ = createIn<ArrayValues>(arena, arena);
+    break;
   case objectValue:
-    value_.map_ = new ObjectValues();
+    value_.map_ = createIn<ObjectValues>(arena, arena);
     break;
   case booleanValue:
     value_.bool_ = false;
@@ -371,6 +1709,10 @@ Value::Value(ValueType vtype) {
   }
 }
 
+Value::Value(Arena& arena, ValueType vtype) : Value(vtype, &arena) {
+  arenaId_ = arena.id_ & 0xFFF;
+}
+
 Value::Value(Int value) {
   initBasic(intValue);
   value_.int_ = value;
@@ -397,21 +1739,19 @@ Value::Value(double value) {
 }
 
 Value::Value(const char* value) {
-  initBasic(stringValue, true);
+  initBasic(stringValue);
   JSON_ASSERT_MESSAGE(value != NULL, "Null Value Passed to Value Constructor");	
-  value_.string_ = duplicateAndPrefixStringValue(value, static_cast<unsigned>(strlen(value)));
+  initString(value, static_cast<unsigned>(strlen(value)));
 }
 
 Value::Value(const char* beginValue, const char* endValue) {
-  initBasic(stringValue, true);
-  value_.string_ =
-      duplicateAndPrefixStringValue(beginValue, static_cast<unsigned>(endValue - beginValue));
+  initBasic(stringValue);
+  initString(beginValue, static_cast<unsigned>(endValue - beginValue));
 }
 
 Value::Value(const JSONCPP_STRING& value) {
-  initBasic(stringValue, true);
-  value_.string_ =
-      duplicateAndPrefixStringValue(value.data(), static_cast<unsigned>(value.length()));
+  initBasic(stringValue);
+  initString(value.data(), static_cast<unsigned>(value.length()));
 }
 
 Value::Value(const StaticString& value) {
@@ -421,8 +1761,8 @@ Value::Value(const StaticString& value) {
 
 #ifdef JSON_USE_CPPTL
 Value::Value(const CppTL::ConstString& value) {
-  initBasic(stringValue, true);
-  value_.string_ = duplicateAndPrefixStringValue(value, static_cast<unsigned>(value.length()));
+  initBasic(stringValue);
+  initString(value, static_cast<unsigned>(value.length()));
 }
 #endif
 
@@ -432,52 +1772,65 @@ Value::Value(bool value) {
 }
 
 Value::Value(Value const& other)
-    : type_(other.type_), allocated_(false)
-      ,
-      comments_(0), start_(other.start_), limit_(other.limit_)
+    : type_(other.type_), allocated_(false), inlined_(other.inlined_),
+      inlineLength_(other.inlineLength_), raw_(other.raw_), stale_(0),
+      arenaId_(0), extra_(0)
 {
   switch (type_) {
   case nullValue:
   case intValue:
   case uintValue:
-  case realValue:
   case booleanValue:
     value_ = other.value_;
     break;
+  case realValue:
+    value_ = other.value_;
+    if (other.allocated_) {
+      value_.string_ = shareNumberText(other.value_.string_);
+      allocated_ = true;
+    }
+    break;
   case stringValue:
     if (other.value_.string_ && other.allocated_) {
-      unsigned len;
-      char const* str;
-      decodePrefixedString(other.allocated_, other.value_.string_,
-          &len, &str);
-      value_.string_ = duplicateAndPrefixStringValue(str, len);
+      value_.string_ = other.raw_
+                           ? shareRawString(other.value_.string_)
+                           : sharePrefixedStringValue(other.value_.string_);
       allocated_ = true;
     } else {
-      value_.string_ = other.value_.string_;
+      // A static string, or an inline one: copy the holder as is.
+      value_ = other.value_;
       allocated_ = false;
     }
     break;
   case arrayValue:
+    value_.array_ = sharePayload(other.value_.array_);
+    break;
   case objectValue:
-    value_.map_ = new ObjectValues(*other.value_.map_);
+    value_.map_ = sharePayload(other.value_.map_);
     break;
   default:
     JSON_ASSERT_UNREACHABLE;
   }
-  if (other.comments_) {
-    comments_ = new CommentInfo[numberOfCommentPlacement];
-    for (int comment = 0; comment < numberOfCommentPlacement; ++comment) {
-      const CommentInfo& otherComment = other.comments_[comment];
-      if (otherComment.comment_)
-        comments_[comment].setComment(
-            otherComment.comment_, strlen(otherComment.comment_));
+  if (other.extra_) {
+    const Extra& otherExtra = *other.getExtra();
+    Extra& extra = demandExtra();
+    extra.start_ = otherExtra.start_;
+    extra.limit_ = otherExtra.limit_;
+    if (otherExtra.comments_) {
+      extra.comments_ = new CommentInfo[numberOfCommentPlacement];
+      for (int comment = 0; comment < numberOfCommentPlacement; ++comment) {
+        const CommentInfo& otherComment = otherExtra.comments_[comment];
+        if (otherComment.comment_)
+          extra.comments_[comment].setComment(
+              otherComment.comment_, strlen(otherComment.comment_));
+      }
     }
   }
 }
 
 #if JSON_HAS_RVALUE_REFERENCES
 // Move constructor
-Value::Value(Value&& other) {
+Value::Value(Value&& other) JSONCPP_NOEXCEPT {
   initBasic(nullValue);
   swap(other);
 }
@@ -488,22 +1841,31 @@ Value::~Value() {
   case nullValue:
   case intValue:
   case uintValue:
-  case realValue:
   case booleanValue:
     break;
-  case stringValue:
+  case realValue:
     if (allocated_)
+      releaseNumberText(value_.string_);
+    break;
+  case stringValue:
+    if (raw_)
+      releaseRawString(value_.string_);
+    else if (allocated_)
       releasePrefixedStringValue(value_.string_);
     break;
   case arrayValue:
+    releasePayload(value_.array_);
+    break;
   case objectValue:
-    delete value_.map_;
+    releasePayload(value_.map_);
     break;
   default:
     JSON_ASSERT_UNREACHABLE;
   }
 
-  delete[] comments_;
+  // The arena of a value gives its comments back when released.
+  if (extra_ && !arenaId_)
+    Extra::release(extra_);
 
   value_.uint_ = 0;
 }
@@ -521,17 +1883,42 @@ void Value::swapPayload(Value& other) {
   int temp2 = allocated_;
   allocated_ = other.allocated_;
   other.allocated_ = temp2 & 0x1;
+  temp2 = inlined_;
+  inlined_ = other.inlined_;
+  other.inlined_ = temp2 & 0x1;
+  temp2 = inlineLength_;
+  inlineLength_ = other.inlineLength_;
+  other.inlineLength_ = temp2 & 0x7;
+  temp2 = raw_;
+  raw_ = other.raw_;
+  other.raw_ = temp2 & 0x1;
+  if (arenaId_)
+    adoptPayload();
+  if (other.arenaId_)
+    other.adoptPayload();
 }
 
 void Value::swap(Value& other) {
   swapPayload(other);
-  std::swap(comments_, other.comments_);
-  std::swap(start_, other.start_);
-  std::swap(limit_, other.limit_);
+  if (arenaId_ == other.arenaId_) {
+    std::swap(extra_, other.extra_);
+  } else if (extra_ || other.extra_) {
+    // Handles stay with the arena that gives them back: swap their records.
+    Extra& extra = demandExtra();
+    Extra& otherExtra = other.demandExtra();
+    std::swap(extra.comments_, otherExtra.comments_);
+    std::swap(extra.start_, otherExtra.start_);
+    std::swap(extra.limit_, otherExtra.limit_);
+  }
+  unsigned int stale = stale_;
+  stale_ = other.stale_;
+  other.stale_ = stale & 0x1;
 }
 
 ValueType Value::type() const { return type_; }
 
+Arena* Value::arena() const { return arenaId_ ? Arena::byId(arenaId_) : 0; }
+
 int Value::compare(const Value& other) const {
   if (*this < other)
     return -1;
@@ -552,21 +1939,20 @@ bool Value::operator<(const Value& other) const {
   case uintValue:
     return value_.uint_ < other.value_.uint_;
   case realValue:
-    return value_.real_ < other.value_.real_;
+    return decodedReal() < other.decodedReal();
   case booleanValue:
     return value_.bool_ < other.value_.bool_;
   case stringValue:
   {
-    if ((value_.string_ == 0) || (other.value_.string_ == 0)) {
-      if (other.value_.string_) return true;
-      else return false;
-    }
     unsigned this_len;
     unsigned other_len;
     char const* this_str;
     char const* other_str;
-    decodePrefixedString(this->allocated_, this->value_.string_, &this_len, &this_str);
-    decodePrefixedString(other.allocated_, other.value_.string_, &other_len, &other_str);
+    bool this_has = decodeString(&this_len, &this_str);
+    bool other_has = other.decodeString(&other_len, &other_str);
+    if (!this_has || !other_has) {
+      return other_has;
+    }
     unsigned min_len = std::min<unsigned>(this_len, other_len);
     JSON_ASSERT(this_str && other_str);
     int comp = memcmp(this_str, other_str, min_len);
@@ -574,7 +1960,12 @@ bool Value::operator<(const Value& other) const {
     if (comp > 0) return false;
     return (this_len < other_len);
   }
-  case arrayValue:
+  case arrayValue: {
+    int delta = int(value_.array_->count() - other.value_.array_->count());
+    if (delta)
+      return delta < 0;
+    return value_.array_->boxed() < other.value_.array_->boxed();
+  }
   case objectValue: {
     int delta = int(value_.map_->size() - other.value_.map_->size());
     if (delta)
@@ -609,29 +2000,35 @@ bool Value::operator==(const Value& other) const {
   case uintValue:
     return value_.uint_ == other.value_.uint_;
   case realValue:
-    return value_.real_ == other.value_.real_;
+    return decodedReal() == other.decodedReal();
   case booleanValue:
     return value_.bool_ == other.value_.bool_;
   case stringValue:
   {
-    if ((value_.string_ == 0) || (other.value_.string_ == 0)) {
-      return (value_.string_ == other.value_.string_);
-    }
     unsigned this_len;
     unsigned other_len;
     char const* this_str;
     char const* other_str;
-    decodePrefixedString(this->allocated_, this->value_.string_, &this_len, &this_str);
-    decodePrefixedString(other.allocated_, other.value_.string_, &other_len, &other_str);
+    bool this_has = decodeString(&this_len, &this_str);
+    bool other_has = other.decodeString(&other_len, &other_str);
+    if (!this_has || !other_has) {
+      return this_has == other_has;
+    }
     if (this_len != other_len) return false;
     JSON_ASSERT(this_str && other_str);
     int comp = memcmp(this_str, other_str, this_len);
     return comp == 0;
   }
   case arrayValue:
+    return value_.array_ == other.value_.array_ ||
+           (value_.array_->count() == other.value_.array_->count() &&
+            !knownToDiffer(*value_.array_, *other.value_.array_) &&
+            value_.array_->sameElements(*other.value_.array_));
   case objectValue:
-    return value_.map_->size() == other.value_.map_->size() &&
-           (*value_.map_) == (*other.value_.map_);
+    return value_.map_ == other.value_.map_ ||
+           (value_.map_->size() == other.value_.map_->size() &&
+            !knownToDiffer(*value_.map_, *other.value_.map_) &&
+            (*value_.map_) == (*other.value_.map_));
   default:
     JSON_ASSERT_UNREACHABLE;
   }
@@ -640,13 +2037,112 @@ bool Value::operator==(const Value& other) const {
 
 bool Value::operator!=(const Value& other) const { return !(*this == other); }
 
+namespace {
+inline size_t hashCombine(size_t seed, size_t value) {
+  return seed ^ (value + static_cast<size_t>(0x9e3779b97f4a7c15ULL) +
+                 (seed << 6) + (seed >> 2));
+}
+
+// FNV-1a, as wide as size_t.
+inline size_t hashBytes(char const* data, size_t length) {
+  size_t hash = static_cast<size_t>(14695981039346656037ULL);
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= static_cast<size_t>(1099511628211ULL);
+  }
+  return hash;
+}
+
+// Remember the digest of a payload that nothing can change behind our back.
+inline size_t rememberDigest(const Value::SharedPayload& payload,
+                             size_t digest) {
+  if (!digest)
+    digest = 1; // 0 means unknown
+  if (payload.shareable_)
+    payload.digest_.store(digest, std::memory_order_relaxed);
+  return digest;
+}
+} // namespace
+
+// Payloads whose digests are both known and differ are not equal.
+bool Value::knownToDiffer(const SharedPayload& a, const SharedPayload& b) {
+  size_t digest = a.digest_.load(std::memory_order_relaxed);
+  size_t otherDigest = b.digest_.load(std::memory_order_relaxed);
+  return digest && otherDigest && digest != otherDigest;
+}
+
+size_t Value::hash() const {
+  size_t seed = hashCombine(0, static_cast<size_t>(type_));
+  switch (type_) {
+  case nullValue:
+    return seed;
+  case intValue:
+    return hashCombine(seed, static_cast<size_t>(value_.int_));
+  case uintValue:
+    return hashCombine(seed, static_cast<size_t>(value_.uint_));
+  case realValue: {
+    // 0.0 == -0.0, so both must hash the same.
+    double real = decodedReal();
+    if (real == 0.0)
+      real = 0.0;
+    LargestUInt bits = 0;
+    memcpy(&bits, &real, std::min(sizeof(bits), sizeof(real)));
+    return hashCombine(seed, static_cast<size_t>(bits));
+  }
+  case booleanValue:
+    return hashCombine(seed, value_.bool_ ? 1u : 0u);
+  case stringValue: {
+    unsigned length;
+    char const* str;
+    if (!decodeString(&length, &str))
+      return seed;
+    return hashCombine(hashCombine(seed, 1u), hashBytes(str, length));
+  }
+  case arrayValue: {
+    if (size_t digest = value_.array_->digest_.load(std::memory_order_relaxed))
+      return digest;
+    size_t hash = hashCombine(seed, value_.array_->count());
+    const double* reals;
+    const double* realsEnd;
+    const LargestInt* ints;
+    const LargestInt* intsEnd;
+    // Packed numbers hash as their Values would, without boxing them.
+    if (getPackedReals(&reals, &realsEnd)) {
+      for (; reals != realsEnd; ++reals)
+        hash = hashCombine(hash, Value(*reals).hash());
+    } else if (getPackedInts(&ints, &intsEnd)) {
+      for (; ints != intsEnd; ++ints)
+        hash = hashCombine(hash, Value(*ints).hash());
+    } else {
+      for (ArrayValues::const_iterator it = value_.array_->begin();
+           it != value_.array_->end(); ++it)
+        hash = hashCombine(hash, it->hash());
+    }
+    return rememberDigest(*value_.array_, hash);
+  }
+  case objectValue: {
+    if (size_t digest = value_.map_->digest_.load(std::memory_order_relaxed))
+      return digest;
+    size_t hash = hashCombine(seed, value_.map_->size());
+    ObjectValues::iterator end = value_.map_->end();
+    for (ObjectValues::iterator it = value_.map_->begin(); it != end; ++it) {
+      hash = hashCombine(hash, hashBytes(it.key().data(), it.key().length()));
+      hash = hashCombine(hash, it.value().hash());
+    }
+    return rememberDigest(*value_.map_, hash);
+  }
+  default:
+    JSON_ASSERT_UNREACHABLE;
+  }
+  return 0; // unreachable
+}
+
 const char* Value::asCString() const {
   JSON_ASSERT_MESSAGE(type_ == stringValue,
                       "in Json::Value::asCString(): requires stringValue");
-  if (value_.string_ == 0) return 0;
   unsigned this_len;
   char const* this_str;
-  decodePrefixedString(this->allocated_, this->value_.string_, &this_len, &this_str);
+  if (!decodeString(&this_len, &this_str)) return 0;
   return this_str;
 }
 
@@ -654,19 +2150,17 @@ const char* Value::asCString() const {
 unsigned Value::getCStringLength() const {
   JSON_ASSERT_MESSAGE(type_ == stringValue,
 	                  "in Json::Value::asCString(): requires stringValue");
-  if (value_.string_ == 0) return 0;
   unsigned this_len;
   char const* this_str;
-  decodePrefixedString(this->allocated_, this->value_.string_, &this_len, &this_str);
+  if (!decodeString(&this_len, &this_str)) return 0;
   return this_len;
 }
 #endif
 
 bool Value::getString(char const** str, char const** cend) const {
   if (type_ != stringValue) return false;
-  if (value_.string_ == 0) return false;
   unsigned length;
-  decodePrefixedString(this->allocated_, this->value_.string_, &length, str);
+  if (!decodeString(&length, str)) return false;
   *cend = *str + length;
   return true;
 }
@@ -677,10 +2171,9 @@ JSONCPP_STRING Value::asString() const {
     return "";
   case stringValue:
   {
-    if (value_.string_ == 0) return "";
     unsigned this_len;
     char const* this_str;
-    decodePrefixedString(this->allocated_, this->value_.string_, &this_len, &this_str);
+    if (!decodeString(&this_len, &this_str)) return "";
     return JSONCPP_STRING(this_str, this_len);
   }
   case booleanValue:
@@ -690,7 +2183,7 @@ JSONCPP_STRING Value::asString() const {
   case uintValue:
     return valueToString(value_.uint_);
   case realValue:
-    return valueToString(value_.real_);
+    return valueToString(decodedReal());
   default:
     JSON_FAIL_MESSAGE("Type is not convertible to string");
   }
@@ -700,8 +2193,7 @@ JSONCPP_STRING Value::asString() const {
 CppTL::ConstString Value::asConstString() const {
   unsigned len;
   char const* str;
-  decodePrefixedString(allocated_, value_.string_,
-      &len, &str);
+  decodeString(&len, &str);
   return CppTL::ConstString(str, len);
 }
 #endif
@@ -715,9 +2207,9 @@ Value::Int Value::asInt() const {
     JSON_ASSERT_MESSAGE(isInt(), "LargestUInt out of Int range");
     return Int(value_.uint_);
   case realValue:
-    JSON_ASSERT_MESSAGE(InRange(value_.real_, minInt, maxInt),
+    JSON_ASSERT_MESSAGE(InRange(decodedReal(), minInt, maxInt),
                         "double out of Int range");
-    return Int(value_.real_);
+    return Int(decodedReal());
   case nullValue:
     return 0;
   case booleanValue:
@@ -737,9 +2229,9 @@ Value::UInt Value::asUInt() const {
     JSON_ASSERT_MESSAGE(isUInt(), "LargestUInt out of UInt range");
     return UInt(value_.uint_);
   case realValue:
-    JSON_ASSERT_MESSAGE(InRange(value_.real_, 0, maxUInt),
+    JSON_ASSERT_MESSAGE(InRange(decodedReal(), 0, maxUInt),
                         "double out of UInt range");
-    return UInt(value_.real_);
+    return UInt(decodedReal());
   case nullValue:
     return 0;
   case booleanValue:
@@ -760,9 +2252,9 @@ Value::Int64 Value::asInt64() const {
     JSON_ASSERT_MESSAGE(isInt64(), "LargestUInt out of Int64 range");
     return Int64(value_.uint_);
   case realValue:
-    JSON_ASSERT_MESSAGE(InRange(value_.real_, minInt64, maxInt64),
+    JSON_ASSERT_MESSAGE(InRange(decodedReal(), minInt64, maxInt64),
                         "double out of Int64 range");
-    return Int64(value_.real_);
+    return Int64(decodedReal());
   case nullValue:
     return 0;
   case booleanValue:
@@ -781,9 +2273,9 @@ Value::UInt64 Value::asUInt64() const {
   case uintValue:
     return UInt64(value_.uint_);
   case realValue:
-    JSON_ASSERT_MESSAGE(InRange(value_.real_, 0, maxUInt64),
+    JSON_ASSERT_MESSAGE(InRange(decodedReal(), 0, maxUInt64),
                         "double out of UInt64 range");
-    return UInt64(value_.real_);
+    return UInt64(decodedReal());
   case nullValue:
     return 0;
   case booleanValue:
@@ -822,7 +2314,7 @@ double Value::asDouble() const {
     return integerToDouble(value_.uint_);
 #endif // if !defined(JSON_USE_INT64_DOUBLE_CONVERSION)
   case realValue:
-    return value_.real_;
+    return decodedReal();
   case nullValue:
     return 0.0;
   case booleanValue:
@@ -845,7 +2337,7 @@ float Value::asFloat() const {
     return static_cast<float>(integerToDouble(value_.uint_));
 #endif // if !defined(JSON_USE_INT64_DOUBLE_CONVERSION)
   case realValue:
-    return static_cast<float>(value_.real_);
+    return static_cast<float>(decodedReal());
   case nullValue:
     return 0.0;
   case booleanValue:
@@ -868,7 +2360,7 @@ bool Value::asBool() const {
     return value_.uint_ ? true : false;
   case realValue:
     // This is kind of strange. Not recommended.
-    return (value_.real_ != 0.0) ? true : false;
+    return (decodedReal() != 0.0) ? true : false;
   default:
     break;
   }
@@ -881,16 +2373,16 @@ bool Value::isConvertibleTo(ValueType other) const {
     return (isNumeric() && asDouble() == 0.0) ||
            (type_ == booleanValue && value_.bool_ == false) ||
            (type_ == stringValue && asString() == "") ||
-           (type_ == arrayValue && value_.map_->size() == 0) ||
-           (type_ == objectValue && value_.map_->size() == 0) ||
+           (type_ == arrayValue && value_.array_->count() == 0) ||
+           (type_ == objectValue && value_.map_->empty()) ||
            type_ == nullValue;
   case intValue:
     return isInt() ||
-           (type_ == realValue && InRange(value_.real_, minInt, maxInt)) ||
+           (type_ == realValue && InRange(decodedReal(), minInt, maxInt)) ||
            type_ == booleanValue || type_ == nullValue;
   case uintValue:
     return isUInt() ||
-           (type_ == realValue && InRange(value_.real_, 0, maxUInt)) ||
+           (type_ == realValue && InRange(decodedReal(), 0, maxUInt)) ||
            type_ == booleanValue || type_ == nullValue;
   case realValue:
     return isNumeric() || type_ == booleanValue || type_ == nullValue;
@@ -918,13 +2410,8 @@ ArrayIndex Value::size() const {
   case booleanValue:
   case stringValue:
     return 0;
-  case arrayValue: // size of the array is highest index + 1
-    if (!value_.map_->empty()) {
-      ObjectValues::const_iterator itLast = value_.map_->end();
-      --itLast;
-      return (*itLast).first.index() + 1;
-    }
-    return 0;
+  case arrayValue:
+    return value_.array_->count();
   case objectValue:
     return ArrayIndex(value_.map_->size());
   }
@@ -945,85 +2432,327 @@ void Value::clear() {
   JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue ||
                           type_ == objectValue,
                       "in Json::Value::clear(): requires complex value");
-  start_ = 0;
-  limit_ = 0;
+  if (Extra* extra = getExtra()) {
+    extra->start_ = 0;
+    extra->limit_ = 0;
+  }
   switch (type_) {
   case arrayValue:
+    if (value_.array_->refs_.load(std::memory_order_acquire) == 1) {
+      value_.array_->clear();
+      value_.array_->dropPacked();
+      value_.array_->digest_.store(0, std::memory_order_relaxed);
+    } else {
+      releasePayload(value_.array_);
+      value_.array_ = new ArrayValues();
+    }
+    break;
   case objectValue:
-    value_.map_->clear();
+    if (value_.map_->refs_.load(std::memory_order_acquire) == 1) {
+      value_.map_->clear();
+      value_.map_->digest_.store(0, std::memory_order_relaxed);
+    } else {
+      releasePayload(value_.map_);
+      value_.map_ = new ObjectValues();
+    }
     break;
   default:
     break;
   }
 }
 
+void Value::reserve(ArrayIndex newCapacity) {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue ||
+                          type_ == objectValue,
+                      "in Json::Value::reserve(): requires complex value");
+  if (type_ == nullValue)
+    *this = Value(arrayValue, arena());
+  detach();
+  if (type_ == arrayValue)
+    value_.array_->reserve(newCapacity);
+  else
+    value_.map_->reserve(newCapacity);
+}
+
+void Value::shrinkToFit() {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue ||
+                          type_ == objectValue,
+                      "in Json::Value::shrinkToFit(): requires complex value");
+  // A shared payload is left alone: detaching it makes a tight copy anyway.
+  if (type_ == arrayValue &&
+      value_.array_->refs_.load(std::memory_order_acquire) == 1)
+    value_.array_->shrink_to_fit();
+  else if (type_ == objectValue &&
+           value_.map_->refs_.load(std::memory_order_acquire) == 1)
+    value_.map_->shrinkToFit();
+}
+
 void Value::resize(ArrayIndex newSize) {
   JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue,
                       "in Json::Value::resize(): requires arrayValue");
   if (type_ == nullValue)
-    *this = Value(arrayValue);
-  ArrayIndex oldSize = size();
-  if (newSize == 0)
+    *this = Value(arrayValue, arena());
+  if (newSize == 0) {
     clear();
-  else if (newSize > oldSize)
-    (*this)[newSize - 1];
-  else {
-    for (ArrayIndex index = newSize; index < oldSize; ++index) {
-      value_.map_->erase(index);
+  } else {
+    detach();
+    value_.array_->resize(newSize);
+  }
+}
+
+Value& Value::operator[](ArrayIndex index) {
+  JSON_ASSERT_MESSAGE(
+      type_ == nullValue || type_ == arrayValue,
+      "in Json::Value::operator[](ArrayIndex): requires arrayValue");
+  if (type_ == nullValue)
+    *this = Value(arrayValue, arena());
+  pin();
+  if (index >= value_.array_->size())
+    value_.array_->resize(index + 1);
+  return (*value_.array_)[index];
+}
+
+Value& Value::operator[](int index) {
+  JSON_ASSERT_MESSAGE(
+      index >= 0,
+      "in Json::Value::operator[](int index): index cannot be negative");
+  return (*this)[ArrayIndex(index)];
+}
+
+const Value& Value::operator[](ArrayIndex index) const {
+  JSON_ASSERT_MESSAGE(
+      type_ == nullValue || type_ == arrayValue,
+      "in Json::Value::operator[](ArrayIndex)const: requires arrayValue");
+  if (type_ == nullValue || index >= value_.array_->count())
+    return nullSingleton();
+  return value_.array_->boxed()[index];
+}
+
+const Value& Value::operator[](int index) const {
+  JSON_ASSERT_MESSAGE(
+      index >= 0,
+      "in Json::Value::operator[](int index) const: index cannot be negative");
+  return (*this)[ArrayIndex(index)];
+}
+
+void Value::initBasic(ValueType vtype, bool allocated) {
+  type_ = vtype;
+  allocated_ = allocated;
+  inlined_ = 0;
+  inlineLength_ = 0;
+  raw_ = 0;
+  stale_ = 0;
+  arenaId_ = 0;
+  extra_ = 0;
+}
+
+void Value::initString(const char* str, unsigned length, Arena* arena) {
+  if (length < sizeof(value_.inline_)) {
+    memcpy(value_.inline_, str, length);
+    memset(value_.inline_ + length, 0, sizeof(value_.inline_) - length);
+    inlined_ = 1;
+    inlineLength_ = length & 0x7;
+  } else {
+    value_.string_ = duplicateAndPrefixStringValue(str, length, arena);
+    allocated_ = 1;
+  }
+}
+
+Value::Extra* Value::getExtra() const {
+  return extra_ ? &Extra::at(extra_) : 0;
+}
+
+Value::Extra& Value::demandExtra() {
+  if (!extra_) {
+    extra_ = Extra::acquire();
+    if (arenaId_)
+      Arena::byId(arenaId_)->extras_.push_back(extra_);
+  }
+  return Extra::at(extra_);
+}
+
+void Value::initNumberText(const char* begin, const char* end, Arena* arena) {
+  value_.string_ =
+      duplicateNumberText(begin, static_cast<unsigned>(end - begin), arena);
+  allocated_ = 1;
+}
+
+double Value::decodedReal() const {
+  return allocated_ ? decodeNumberText(value_.string_) : value_.real_;
+}
+
+bool Value::getNumberText(char const** begin, char const** end) const {
+  if (type_ != realValue || !allocated_)
+    return false;
+  *begin = value_.string_ + sizeof(NumberText);
+  *end = *begin + reinterpret_cast<NumberText const*>(value_.string_)->length_;
+  return true;
+}
+
+void Value::initRawString(const char* begin, const char* end, bool escaped,
+                          bool verbatim, Arena* arena) {
+  value_.string_ = duplicateRawString(
+      begin, static_cast<unsigned>(end - begin), escaped, verbatim, arena);
+  allocated_ = 1;
+  raw_ = 1;
+}
+
+void Value::settle(Value& value, Arena& arena) {
+  value.arenaId_ = arena.id_ & 0xFFF;
+  if (value.extra_)
+    arena.extras_.push_back(value.extra_);
+  value.adoptPayload();
+}
+
+void Value::adoptPayload() {
+  Arena& arena = *Arena::byId(arenaId_);
+  switch (type_) {
+  case realValue:
+    if (allocated_ && arenaOfBlock(value_.string_) != arenaId_) {
+      char* text = duplicateNumberText(
+          value_.string_ + sizeof(NumberText),
+          reinterpret_cast<NumberText*>(value_.string_)->length_, &arena);
+      releaseNumberText(value_.string_);
+      value_.string_ = text;
+    }
+    break;
+  case stringValue:
+    if (allocated_ && arenaOfBlock(value_.string_) != arenaId_) {
+      RawString* raw = reinterpret_cast<RawString*>(value_.string_);
+      bool keepRaw = raw_ && !raw->escaped_;
+      char* string;
+      if (keepRaw) {
+        string = duplicateRawString(value_.string_ + sizeof(RawString),
+                                    raw->length_, false, raw->verbatim_,
+                                    &arena);
+      } else {
+        // Escaped text is unescaped now, rather than when first used.
+        unsigned length;
+        char const* str;
+        decodeString(&length, &str);
+        string = duplicateAndPrefixStringValue(str, length, &arena);
+      }
+      if (raw_)
+        releaseRawString(value_.string_);
+      else
+        releasePrefixedStringValue(value_.string_);
+      raw_ = keepRaw;
+      value_.string_ = string;
     }
-    JSON_ASSERT(size() == newSize);
+    break;
+  case arrayValue:
+    if (value_.array_->arena_ != &arena) {
+      ArrayValues* elements = value_.array_;
+      elements->boxed();
+      ArrayValues* adopted = createIn<ArrayValues>(&arena, &arena);
+      adopted->reserve(elements->size());
+      // The elements of a payload of its own are moved, others copied.
+      bool own = !elements->arena_ &&
+                 elements->refs_.load(std::memory_order_acquire) == 1;
+      for (ArrayValues::iterator it = elements->begin();
+           it != elements->end(); ++it) {
+        if (own)
+          adopted->push_back(std::move(*it));
+        else
+          adopted->push_back(*it);
+      }
+      releasePayload(elements);
+      value_.array_ = adopted;
+    }
+    break;
+  case objectValue:
+    if (value_.map_->arena_ != &arena) {
+      ObjectValues* members = value_.map_;
+      ObjectValues* adopted = createIn<ObjectValues>(&arena, &arena);
+      adopted->reserve(members->size());
+      bool own = !members->arena_ &&
+                 members->refs_.load(std::memory_order_acquire) == 1;
+      ObjectValues::iterator end = members->end();
+      for (ObjectValues::iterator it = members->begin(); it != end; ++it) {
+        Value member;
+        if (own)
+          member.swap(it.value());
+        else
+          member = it.value();
+        adopted->assign(it.key(), member);
+      }
+      releasePayload(members);
+      value_.map_ = adopted;
+    }
+    break;
+  default:
+    break;
   }
 }
 
-Value& Value::operator[](ArrayIndex index) {
-  JSON_ASSERT_MESSAGE(
-      type_ == nullValue || type_ == arrayValue,
-      "in Json::Value::operator[](ArrayIndex): requires arrayValue");
-  if (type_ == nullValue)
-    *this = Value(arrayValue);
-  CZString key(index);
-  ObjectValues::iterator it = value_.map_->lower_bound(key);
-  if (it != value_.map_->end() && (*it).first == key)
-    return (*it).second;
-
-  ObjectValues::value_type defaultValue(key, nullSingleton());
-  it = value_.map_->insert(it, defaultValue);
-  return (*it).second;
+bool Value::getRawString(char const** begin, char const** end) const {
+  if (type_ != stringValue || !raw_ ||
+      !reinterpret_cast<RawString const*>(value_.string_)->verbatim_)
+    return false;
+  *begin = value_.string_ + sizeof(RawString);
+  *end = *begin + reinterpret_cast<RawString const*>(value_.string_)->length_;
+  return true;
+}
+
+bool Value::getPackedReals(double const** begin, double const** end) const {
+  if (type_ != arrayValue || !value_.array_->packed_ ||
+      value_.array_->packed_->type_ != realValue)
+    return false;
+  const std::vector<double>& reals = value_.array_->packed_->reals_;
+  *begin = reals.data();
+  *end = reals.data() + reals.size();
+  return true;
 }
 
-Value& Value::operator[](int index) {
-  JSON_ASSERT_MESSAGE(
-      index >= 0,
-      "in Json::Value::operator[](int index): index cannot be negative");
-  return (*this)[ArrayIndex(index)];
+bool Value::getPackedInts(LargestInt const** begin,
+                          LargestInt const** end) const {
+  if (type_ != arrayValue || !value_.array_->packed_ ||
+      value_.array_->packed_->type_ != intValue)
+    return false;
+  const std::vector<LargestInt>& ints = value_.array_->packed_->ints_;
+  *begin = ints.data();
+  *end = ints.data() + ints.size();
+  return true;
 }
 
-const Value& Value::operator[](ArrayIndex index) const {
-  JSON_ASSERT_MESSAGE(
-      type_ == nullValue || type_ == arrayValue,
-      "in Json::Value::operator[](ArrayIndex)const: requires arrayValue");
-  if (type_ == nullValue)
-    return nullSingleton();
-  CZString key(index);
-  ObjectValues::const_iterator it = value_.map_->find(key);
-  if (it == value_.map_->end())
-    return nullSingleton();
-  return (*it).second;
+bool Value::decodeString(unsigned* length, char const** str) const {
+  if (inlined_) {
+    *length = inlineLength_;
+    *str = value_.inline_;
+    return true;
+  }
+  if (value_.string_ == 0) return false;
+  if (raw_)
+    decodeRawString(value_.string_, length, str);
+  else
+    decodePrefixedString(allocated_, value_.string_, length, str);
+  return true;
 }
 
-const Value& Value::operator[](int index) const {
-  JSON_ASSERT_MESSAGE(
-      index >= 0,
-      "in Json::Value::operator[](int index) const: index cannot be negative");
-  return (*this)[ArrayIndex(index)];
+void Value::detach() {
+  if (type_ == arrayValue) {
+    detachPayload(value_.array_);
+    value_.array_->unpack();
+    value_.array_->digest_.store(0, std::memory_order_relaxed);
+  } else if (type_ == objectValue) {
+    detachPayload(value_.map_);
+    value_.map_->digest_.store(0, std::memory_order_relaxed);
+  }
 }
 
-void Value::initBasic(ValueType vtype, bool allocated) {
-  type_ = vtype;
-  allocated_ = allocated;
-  comments_ = 0;
-  start_ = 0;
-  limit_ = 0;
+void Value::pin() {
+  detach();
+  if (type_ == arrayValue)
+    value_.array_->shareable_ = false;
+  else if (type_ == objectValue)
+    value_.map_->shareable_ = false;
+}
+
+void Value::unpin() {
+  if (type_ == arrayValue)
+    value_.array_->shareable_ = true;
+  else if (type_ == objectValue)
+    value_.map_->shareable_ = true;
 }
 
 // Access an object value by name, create a null member if it does not exist.
@@ -1034,17 +2763,11 @@ Value& Value::resolveReference(const char* key) {
       type_ == nullValue || type_ == objectValue,
       "in Json::Value::resolveReference(): requires objectValue");
   if (type_ == nullValue)
-    *this = Value(objectValue);
+    *this = Value(objectValue, arena());
+  pin();
   CZString actualKey(
       key, static_cast<unsigned>(strlen(key)), CZString::noDuplication); // NOTE!
-  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
-  if (it != value_.map_->end() && (*it).first == actualKey)
-    return (*it).second;
-
-  ObjectValues::value_type defaultValue(actualKey, nullSingleton());
-  it = value_.map_->insert(it, defaultValue);
-  Value& value = (*it).second;
-  return value;
+  return value_.map_->resolve(actualKey);
 }
 
 // @param key is not null-terminated.
@@ -1053,18 +2776,25 @@ Value& Value::resolveReference(char const* key, char const* cend)
   JSON_ASSERT_MESSAGE(
       type_ == nullValue || type_ == objectValue,
       "in Json::Value::resolveReference(key, end): requires objectValue");
+  Value empty;
+  return placeMember(key, cend, empty, false);
+}
+
+// Find the member named [key, cend), or add it with the payload of value.
+// An existing member also takes that payload if overwrite.
+Value& Value::placeMember(char const* key, char const* cend, Value& value,
+                          bool overwrite) {
   if (type_ == nullValue)
-    *this = Value(objectValue);
-  CZString actualKey(
-      key, static_cast<unsigned>(cend-key), CZString::duplicateOnCopy);
-  ObjectValues::iterator it = value_.map_->lower_bound(actualKey);
-  if (it != value_.map_->end() && (*it).first == actualKey)
-    return (*it).second;
-
-  ObjectValues::value_type defaultValue(actualKey, nullSingleton());
-  it = value_.map_->insert(it, defaultValue);
-  Value& value = (*it).second;
-  return value;
+    *this = Value(objectValue, arena());
+  pin();
+  unsigned length = static_cast<unsigned>(cend - key);
+  CZString actualKey(key, length, CZString::duplicateOnCopy);
+  // Only the names of new members are interned.
+  if (KeyPool::isEnabled() && value_.map_->find(actualKey) == value_.map_->end())
+    if (char const* interned = KeyPool::intern(key, cend))
+      actualKey = CZString(interned, length, CZString::noDuplication);
+  return overwrite ? value_.map_->assign(actualKey, value)
+                   : value_.map_->resolve(actualKey);
 }
 
 Value Value::get(ArrayIndex index, const Value& defaultValue) const {
@@ -1072,6 +2802,157 @@ Value Value::get(ArrayIndex index, const Value& defaultValue) const {
   return value == &nullSingleton() ? defaultValue : *value;
 }
 
+void Value::reset() {
+  switch (type_) {
+  case arrayValue:
+    if (value_.array_->refs_.load(std::memory_order_acquire) == 1) {
+      value_.array_->clear(); // keeps the capacity
+      value_.array_->dropPacked();
+      value_.array_->digest_.store(0, std::memory_order_relaxed);
+    } else {
+      releasePayload(value_.array_);
+      value_.array_ = new ArrayValues();
+    }
+    break;
+  case objectValue:
+    if (value_.map_->refs_.load(std::memory_order_acquire) == 1) {
+      value_.map_->reset();
+      value_.map_->digest_.store(0, std::memory_order_relaxed);
+    } else {
+      releasePayload(value_.map_);
+      value_.map_ = new ObjectValues();
+    }
+    break;
+  default: {
+    Value empty;
+    swapPayload(empty);
+  } break;
+  }
+  if (Extra* extra = getExtra()) {
+    extra->start_ = 0;
+    extra->limit_ = 0;
+  }
+}
+
+void Value::startReuse() {
+  pin();
+  if (type_ == arrayValue) {
+    for (ArrayValues::iterator it = value_.array_->begin();
+         it != value_.array_->end(); ++it)
+      it->stale_ = 1;
+  } else if (type_ == objectValue) {
+    ObjectValues::iterator end = value_.map_->end();
+    for (ObjectValues::iterator it = value_.map_->begin(); it != end; ++it)
+      it.value().stale_ = 1;
+  }
+}
+
+Value* Value::reuseElement(ArrayIndex index) {
+  if (index >= value_.array_->size())
+    return NULL;
+  Value& element = (*value_.array_)[index];
+  if (!element.stale_)
+    return NULL;
+  element.stale_ = 0;
+  if (element.extra_ && !element.arenaId_) {
+    Extra::release(element.extra_);
+    element.extra_ = 0;
+  } else if (element.extra_) {
+    Extra::at(element.extra_).clear();
+  }
+  return &element;
+}
+
+Value* Value::reuseMember(const char* key, const char* cend) {
+  CZString actualKey(key, static_cast<unsigned>(cend - key),
+                     CZString::noDuplication);
+  ObjectValues::iterator it = value_.map_->find(actualKey);
+  if (it == value_.map_->end() || !it.value().stale_)
+    return NULL;
+  Value& member = it.value();
+  member.stale_ = 0;
+  if (member.extra_ && !member.arenaId_) {
+    Extra::release(member.extra_);
+    member.extra_ = 0;
+  } else if (member.extra_) {
+    Extra::at(member.extra_).clear();
+  }
+  return &member;
+}
+
+void Value::finishReuse() {
+  if (type_ == arrayValue) {
+    // Elements are read in order: the stale ones are at the end.
+    ArrayValues& elements = *value_.array_;
+    size_t size = elements.size();
+    while (size && elements[size - 1].stale_)
+      --size;
+    elements.resize(size);
+  } else if (type_ == objectValue) {
+    ObjectValues::iterator it = value_.map_->begin();
+    while (it != value_.map_->end()) {
+      if (it.value().stale_)
+        it = value_.map_->erase(it);
+      else
+        ++it;
+    }
+  }
+}
+
+void Value::reuseString(const char* str, unsigned length, Arena* arena) {
+  if (type_ == stringValue && allocated_ && !raw_ &&
+      length >= sizeof(value_.inline_)) {
+    // Strings in an arena are never shared.
+    StringPrefix* prefix = reinterpret_cast<StringPrefix*>(value_.string_);
+    if ((prefix->refs_.load(std::memory_order_acquire) == 1 ||
+         arenaOfBlock(value_.string_)) &&
+        length <= prefix->capacity_) {
+      memcpy(value_.string_ + sizeof(StringPrefix), str, length);
+      value_.string_[sizeof(StringPrefix) + length] = 0;
+      prefix->length_ = length;
+      return;
+    }
+  }
+  Value string(stringValue);
+  string.initString(str, length, arena);
+  swapPayload(string);
+}
+
+void Value::packNumbers() {
+  ArrayValues& elements = *value_.array_;
+  if (elements.packed_ || elements.arena_ || elements.size() < minPackedSize)
+    return;
+  ValueType type = elements.front().type();
+  if (type != intValue && type != realValue)
+    return;
+  for (ArrayValues::const_iterator it = elements.begin(); it != elements.end();
+       ++it) {
+    if (it->type_ != type || it->allocated_ || it->extra_)
+      return; // numbers with comments or offsets keep them
+  }
+  ArrayValues::Packed* packed = new ArrayValues::Packed(type);
+  if (type == intValue) {
+    packed->ints_.reserve(elements.size());
+    for (ArrayValues::const_iterator it = elements.begin();
+         it != elements.end(); ++it)
+      packed->ints_.push_back(it->value_.int_);
+  } else {
+    packed->reals_.reserve(elements.size());
+    for (ArrayValues::const_iterator it = elements.begin();
+         it != elements.end(); ++it)
+      packed->reals_.push_back(it->value_.real_);
+  }
+  // Swapped out rather than cleared, to free the storage as well.
+  std::vector<Value, ArenaAllocator<Value> >(elements.get_allocator())
+      .swap(elements);
+  elements.packed_ = packed;
+}
+
+void Value::shareShape(Shape*& last, UInt& candidate) {
+  if (type_ == objectValue && !value_.map_->arena_ && !value_.map_->empty())
+    value_.map_->share(last, candidate);
+}
+
 bool Value::isValidIndex(ArrayIndex index) const { return index < size(); }
 
 Value const* Value::find(char const* key, char const* cend) const
@@ -1081,9 +2962,9 @@ Value const* Value::find(char const* key, char const* cend) const
       "in Json::Value::find(key, end, found): requires objectValue or nullValue");
   if (type_ == nullValue) return NULL;
   CZString actualKey(key, static_cast<unsigned>(cend-key), CZString::noDuplication);
-  ObjectValues::const_iterator it = value_.map_->find(actualKey);
+  ObjectValues::iterator it = value_.map_->find(actualKey);
   if (it == value_.map_->end()) return NULL;
-  return &(*it).second;
+  return &it.value();
 }
 const Value& Value::operator[](const char* key) const
 {
@@ -1122,7 +3003,51 @@ Value const& Value::operator[](CppTL::ConstString const& key) const
 }
 #endif
 
-Value& Value::append(const Value& value) { return (*this)[size()] = value; }
+#if JSON_HAS_RVALUE_REFERENCES
+Value& Value::insert(char const* key, char const* cend, Value&& value) {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == objectValue,
+                      "in Json::Value::insert(): requires objectValue");
+  return placeMember(key, cend, value, true);
+}
+
+Value& Value::insert(JSONCPP_STRING const& key, Value&& value) {
+  return insert(key.data(), key.data() + key.length(), std::move(value));
+}
+
+Value& Value::insert(const StaticString& key, Value&& value) {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == objectValue,
+                      "in Json::Value::insert(): requires objectValue");
+  if (type_ == nullValue)
+    *this = Value(objectValue, arena());
+  pin();
+  CZString actualKey(key.c_str(), static_cast<unsigned>(strlen(key.c_str())),
+                     CZString::noDuplication);
+  return value_.map_->assign(actualKey, value);
+}
+#endif
+
+Value::ArrayValues& Value::demandArray() {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue,
+                      "in Json::Value::append(): requires arrayValue");
+  if (type_ == nullValue)
+    *this = Value(arrayValue, arena());
+  pin();
+  return *value_.array_;
+}
+
+Value& Value::append(const Value& value) {
+  ArrayValues& array = demandArray();
+  array.push_back(value);
+  return array.back();
+}
+
+#if JSON_HAS_RVALUE_REFERENCES
+Value& Value::append(Value&& value) {
+  ArrayValues& array = demandArray();
+  array.push_back(std::move(value));
+  return array.back();
+}
+#endif
 
 Value Value::get(char const* key, char const* cend, Value const& defaultValue) const
 {
@@ -1148,8 +3073,13 @@ bool Value::removeMember(const char* key, const char* cend, Value* removed)
   ObjectValues::iterator it = value_.map_->find(actualKey);
   if (it == value_.map_->end())
     return false;
-  *removed = it->second;
+  if (value_.map_->refs_.load(std::memory_order_acquire) != 1) {
+    detach();
+    it = value_.map_->find(actualKey);
+  }
+  removed->swap(it.value());
   value_.map_->erase(it);
+  value_.map_->digest_.store(0, std::memory_order_relaxed);
   return true;
 }
 bool Value::removeMember(const char* key, Value* removed)
@@ -1176,29 +3106,147 @@ Value Value::removeMember(const JSONCPP_STRING& key)
   return removeMember(key.c_str());
 }
 
+Value& Value::operator[](const Key& key) {
+  JSON_ASSERT_MESSAGE(
+      type_ == nullValue || type_ == objectValue,
+      "in Json::Value::operator[](Key): requires objectValue");
+  if (type_ == nullValue)
+    *this = Value(objectValue, arena());
+  pin();
+  // A pooled name outlives the object, so it need not be copied.
+  CZString actualKey(key.data(), key.length(),
+                     key.isInterned() ? CZString::noDuplication
+                                      : CZString::duplicateOnCopy);
+  ObjectValues::iterator it = value_.map_->find(actualKey, key.hash());
+  if (it != value_.map_->end())
+    return it.value();
+  return value_.map_->resolve(actualKey);
+}
+
+const Value& Value::operator[](const Key& key) const {
+  Value const* found = find(key);
+  if (!found) return nullSingleton();
+  return *found;
+}
+
+Value const* Value::find(const Key& key) const {
+  JSON_ASSERT_MESSAGE(
+      type_ == nullValue || type_ == objectValue,
+      "in Json::Value::find(Key): requires objectValue or nullValue");
+  if (type_ == nullValue) return NULL;
+  CZString actualKey(key.data(), key.length(), CZString::noDuplication);
+  ObjectValues::iterator it = value_.map_->find(actualKey, key.hash());
+  if (it == value_.map_->end()) return NULL;
+  return &it.value();
+}
+
+Value Value::get(const Key& key, const Value& defaultValue) const {
+  Value const* found = find(key);
+  return !found ? defaultValue : *found;
+}
+
+bool Value::isMember(const Key& key) const { return find(key) != NULL; }
+
+Value Value::removeMember(const Key& key) {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == objectValue,
+                      "in Json::Value::removeMember(): requires objectValue");
+  if (type_ == nullValue)
+    return nullSingleton();
+
+  Value removed;  // null
+  removeMember(key, &removed);
+  return removed; // still null if removeMember() did nothing
+}
+
+bool Value::removeMember(const Key& key, Value* removed) {
+  if (type_ != objectValue) {
+    return false;
+  }
+  CZString actualKey(key.data(), key.length(), CZString::noDuplication);
+  ObjectValues::iterator it = value_.map_->find(actualKey, key.hash());
+  if (it == value_.map_->end())
+    return false;
+  if (value_.map_->refs_.load(std::memory_order_acquire) != 1) {
+    detach();
+    it = value_.map_->find(actualKey, key.hash());
+  }
+  removed->swap(it.value());
+  value_.map_->erase(it);
+  value_.map_->digest_.store(0, std::memory_order_relaxed);
+  return true;
+}
+
 bool Value::removeIndex(ArrayIndex index, Value* removed) {
   if (type_ != arrayValue) {
     return false;
   }
-  CZString key(index);
-  ObjectValues::iterator it = value_.map_->find(key);
-  if (it == value_.map_->end()) {
+  if (index >= value_.array_->count()) {
     return false;
   }
-  *removed = it->second;
-  ArrayIndex oldSize = size();
-  // shift left all items left, into the place of the "removed"
-  for (ArrayIndex i = index; i < (oldSize - 1); ++i){
-    CZString keey(i);
-    (*value_.map_)[keey] = (*this)[i + 1];
-  }
-  // erase the last one ("leftover")
-  CZString keyLast(oldSize - 1);
-  ObjectValues::iterator itLast = value_.map_->find(keyLast);
-  value_.map_->erase(itLast);
+  detach();
+  ArrayValues::iterator it = value_.array_->begin() + index;
+  removed->swap(*it);
+  // shift all later items left, into the place of the "removed"
+  value_.array_->erase(it);
+  return true;
+}
+
+bool Value::erase(ArrayIndex first, ArrayIndex last) {
+  if (type_ != arrayValue)
+    return false;
+  if (first > last || last > value_.array_->count())
+    return false;
+  if (first == last)
+    return true;
+  detach();
+  ArrayValues::iterator begin = value_.array_->begin();
+  value_.array_->erase(begin + first, begin + last);
+  return true;
+}
+
+bool Value::insert(ArrayIndex index, const Value& value) {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue,
+                      "in Json::Value::insert(): requires arrayValue");
+  if (index > size())
+    return false;
+  Value copy(value); // value may be an element of this array
+  if (type_ == nullValue)
+    *this = Value(arrayValue, arena());
+  detach();
+  value_.array_->insert(value_.array_->begin() + index, Value())->swap(copy);
   return true;
 }
 
+#if JSON_HAS_RVALUE_REFERENCES
+bool Value::insert(ArrayIndex index, Value&& value) {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue,
+                      "in Json::Value::insert(): requires arrayValue");
+  if (index > size())
+    return false;
+  Value moved; // value may be an element of this array
+  moved.swap(value);
+  if (type_ == nullValue)
+    *this = Value(arrayValue, arena());
+  detach();
+  value_.array_->insert(value_.array_->begin() + index, Value())->swap(moved);
+  return true;
+}
+#endif
+
+void Value::truncate(ArrayIndex newSize) {
+  JSON_ASSERT_MESSAGE(type_ == nullValue || type_ == arrayValue,
+                      "in Json::Value::truncate(): requires arrayValue");
+  if (type_ == nullValue || newSize >= value_.array_->count())
+    return;
+  if (newSize == 0) {
+    clear();
+    return;
+  }
+  detach();
+  value_.array_->erase(value_.array_->begin() + newSize,
+                       value_.array_->end());
+}
+
 #ifdef JSON_USE_CPPTL
 Value Value::get(const CppTL::ConstString& key,
                  const Value& defaultValue) const {
@@ -1226,6 +3274,69 @@ bool Value::isMember(const CppTL::ConstString& key) const {
 }
 #endif
 
+void Value::mergePatch(const Value& patch) {
+  if (patch.type_ != objectValue) {
+    *this = patch;
+    return;
+  }
+  if (type_ != objectValue)
+    *this = Value(objectValue, arena());
+  // placeMember() pins the members it returns; no reference escapes here.
+  bool pinned = !value_.map_->shareable_;
+  patch.forEachMember(
+      [this](char const* name, unsigned length, const Value& value) {
+        if (value.type_ == nullValue) {
+          Value removed;
+          removeMember(name, name + length, &removed);
+        } else if (value.type_ == objectValue) {
+          resolveReference(name, name + length).mergePatch(value);
+        } else {
+          Value copy(value);
+          placeMember(name, name + length, copy, true);
+        }
+      });
+  if (!pinned)
+    unpin();
+}
+
+#if JSON_HAS_RVALUE_REFERENCES
+void Value::mergePatch(Value&& patch) {
+  if (patch.type_ != objectValue) {
+    *this = std::move(patch);
+    return;
+  }
+  // The members of a shared patch cannot be taken; copying them only shares
+  // their payloads in turn.
+  if (patch.value_.map_->refs_.load(std::memory_order_acquire) != 1) {
+    mergePatch(static_cast<const Value&>(patch));
+    Value().swap(patch);
+    return;
+  }
+  if (type_ != objectValue)
+    *this = Value(objectValue, arena());
+  bool pinned = !value_.map_->shareable_;
+  ObjectValues::iterator end = patch.value_.map_->end();
+  for (ObjectValues::iterator it = patch.value_.map_->begin(); it != end;
+       ++it) {
+    const CZString& name = it.key();
+    char const* begin = name.data();
+    char const* cend = begin + name.length();
+    Value& value = it.value();
+    if (value.type_ == nullValue) {
+      Value removed;
+      removeMember(begin, cend, &removed);
+    } else if (value.type_ == objectValue) {
+      resolveReference(begin, cend).mergePatch(std::move(value));
+    } else {
+      placeMember(begin, cend, value, true);
+    }
+  }
+  if (!pinned)
+    unpin();
+  Value().swap(patch);
+}
+#endif
+
 Value::Members Value::getMemberNames() const {
   JSON_ASSERT_MESSAGE(
       type_ == nullValue || type_ == objectValue,
@@ -1234,11 +3345,11 @@ Value::Members Value::getMemberNames() const {
     return Value::Members();
   Members members;
   members.reserve(value_.map_->size());
-  ObjectValues::const_iterator it = value_.map_->begin();
-  ObjectValues::const_iterator itEnd = value_.map_->end();
+  ObjectValues::iterator it = value_.map_->begin();
+  ObjectValues::iterator itEnd = value_.map_->end();
   for (; it != itEnd; ++it) {
-    members.push_back(JSONCPP_STRING((*it).first.data(),
-                                  (*it).first.length()));
+    members.push_back(JSONCPP_STRING(it.key().data(),
+                                  it.key().length()));
   }
   return members;
 }
@@ -1287,9 +3398,10 @@ bool Value::isInt() const {
 #endif
   case uintValue:
     return value_.uint_ <= UInt(maxInt);
-  case realValue:
-    return value_.real_ >= minInt && value_.real_ <= maxInt &&
-           IsIntegral(value_.real_);
+  case realValue: {
+    double real = decodedReal();
+    return real >= minInt && real <= maxInt && IsIntegral(real);
+  }
   default:
     break;
   }
@@ -1310,9 +3422,10 @@ bool Value::isUInt() const {
 #else
     return true;
 #endif
-  case realValue:
-    return value_.real_ >= 0 && value_.real_ <= maxUInt &&
-           IsIntegral(value_.real_);
+  case realValue: {
+    double real = decodedReal();
+    return real >= 0 && real <= maxUInt && IsIntegral(real);
+  }
   default:
     break;
   }
@@ -1326,12 +3439,14 @@ bool Value::isInt64() const {
     return true;
   case uintValue:
     return value_.uint_ <= UInt64(maxInt64);
-  case realValue:
+  case realValue: {
     // Note that maxInt64 (= 2^63 - 1) is not exactly representable as a
     // double, so double(maxInt64) will be rounded up to 2^63. Therefore we
     // require the value to be strictly less than the limit.
-    return value_.real_ >= double(minInt64) &&
-           value_.real_ < double(maxInt64) && IsIntegral(value_.real_);
+    double real = decodedReal();
+    return real >= double(minInt64) && real < double(maxInt64) &&
+           IsIntegral(real);
+  }
   default:
     break;
   }
@@ -1346,12 +3461,13 @@ bool Value::isUInt64() const {
     return value_.int_ >= 0;
   case uintValue:
     return true;
-  case realValue:
+  case realValue: {
     // Note that maxUInt64 (= 2^64 - 1) is not exactly representable as a
     // double, so double(maxUInt64) will be rounded up to 2^64. Therefore we
     // require the value to be strictly less than the limit.
-    return value_.real_ >= 0 && value_.real_ < maxUInt64AsDouble &&
-           IsIntegral(value_.real_);
+    double real = decodedReal();
+    return real >= 0 && real < maxUInt64AsDouble && IsIntegral(real);
+  }
   default:
     break;
   }
@@ -1378,13 +3494,14 @@ bool Value::isArray() const { return type_ == arrayValue; }
 bool Value::isObject() const { return type_ == objectValue; }
 
 void Value::setComment(const char* comment, size_t len, CommentPlacement placement) {
-  if (!comments_)
-    comments_ = new CommentInfo[numberOfCommentPlacement];
+  Extra& extra = demandExtra();
+  if (!extra.comments_)
+    extra.comments_ = new CommentInfo[numberOfCommentPlacement];
   if ((len > 0) && (comment[len-1] == '\n')) {
     // Always discard trailing newline, to aid indentation.
     len -= 1;
   }
-  comments_[placement].setComment(comment, len);
+  extra.comments_[placement].setComment(comment, len);
 }
 
 void Value::setComment(const char* comment, CommentPlacement placement) {
@@ -1396,22 +3513,35 @@ void Value::setComment(const JSONCPP_STRING& comment, CommentPlacement placement
 }
 
 bool Value::hasComment(CommentPlacement placement) const {
-  return comments_ != 0 && comments_[placement].comment_ != 0;
+  Extra const* extra = getExtra();
+  return extra != 0 && extra->comments_ != 0 &&
+         extra->comments_[placement].comment_ != 0;
 }
 
 JSONCPP_STRING Value::getComment(CommentPlacement placement) const {
   if (hasComment(placement))
-    return comments_[placement].comment_;
+    return getExtra()->comments_[placement].comment_;
   return "";
 }
 
-void Value::setOffsetStart(ptrdiff_t start) { start_ = start; }
+// A zero offset is the default, and needs no room in the side table.
+void Value::setOffsetStart(ptrdiff_t start) {
+  if (start || extra_)
+    demandExtra().start_ = start;
+}
 
-void Value::setOffsetLimit(ptrdiff_t limit) { limit_ = limit; }
+void Value::setOffsetLimit(ptrdiff_t limit) {
+  if (limit || extra_)
+    demandExtra().limit_ = limit;
+}
 
-ptrdiff_t Value::getOffsetStart() const { return start_; }
+ptrdiff_t Value::getOffsetStart() const {
+  return extra_ ? getExtra()->start_ : 0;
+}
 
-ptrdiff_t Value::getOffsetLimit() const { return limit_; }
+ptrdiff_t Value::getOffsetLimit() const {
+  return extra_ ? getExtra()->limit_ : 0;
+}
 
 JSONCPP_STRING Value::toStyledString() const {
   StyledWriter writer;
@@ -1421,6 +3551,11 @@ JSONCPP_STRING Value::toStyledString() const {
 Value::const_iterator Value::begin() const {
   switch (type_) {
   case arrayValue:
+    if (value_.array_) {
+      value_.array_->boxed();
+      return const_iterator(value_.array_, 0);
+    }
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->begin());
@@ -1434,6 +3569,11 @@ Value::const_iterator Value::begin() const {
 Value::const_iterator Value::end() const {
   switch (type_) {
   case arrayValue:
+    if (value_.array_) {
+      value_.array_->boxed();
+      return const_iterator(value_.array_, ArrayIndex(value_.array_->count()));
+    }
+    break;
   case objectValue:
     if (value_.map_)
       return const_iterator(value_.map_->end());
@@ -1445,8 +3585,12 @@ Value::const_iterator Value::end() const {
 }
 
 Value::iterator Value::begin() {
+  pin();
   switch (type_) {
   case arrayValue:
+    if (value_.array_)
+      return iterator(value_.array_, 0);
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->begin());
@@ -1458,8 +3602,12 @@ Value::iterator Value::begin() {
 }
 
 Value::iterator Value::end() {
+  pin();
   switch (type_) {
   case arrayValue:
+    if (value_.array_)
+      return iterator(value_.array_, ArrayIndex(value_.array_->size()));
+    break;
   case objectValue:
     if (value_.map_)
       return iterator(value_.map_->end());
@@ -1470,6 +3618,290 @@ Value::iterator Value::end() {
   return iterator();
 }
 
+// memoryUsage
+// //////////////////////////////////////////////////////////////////
+
+Value::MemoryUsage::MemoryUsage()
+    : nodes(0), containers(0), keys(0), strings(0), comments(0) {}
+
+size_t Value::MemoryUsage::total() const {
+  return nodes + containers + keys + strings + comments;
+}
+
+Value::MemoryUsage& Value::MemoryUsage::operator+=(const MemoryUsage& other) {
+  nodes += other.nodes;
+  containers += other.containers;
+  keys += other.keys;
+  strings += other.strings;
+  comments += other.comments;
+  return *this;
+}
+
+struct Value::UsageWalk {
+  // Elements or members of an array or object measured when approximate.
+  static const size_t sampleSize = 16;
+  // Header of a node of std::map: its color and three links.
+  static const size_t treeNodeHeader = 4 * sizeof(void*);
+
+  explicit UsageWalk(bool approximate) : approximate_(approximate) {}
+
+  /// \return whether to count block: always if it cannot be shared,
+  /// otherwise the first time it is met.
+  bool counts(const void* block, bool shared) {
+    return !shared || approximate_ || seen_.insert(block).second;
+  }
+  /// \return whether to count a block starting with a StringPrefix.
+  bool countsString(char const* block) {
+    unsigned refs = reinterpret_cast<StringPrefix const*>(block)->refs_.load(
+        std::memory_order_relaxed);
+    return counts(block, !(refs & arenaBlock) && refs > 1);
+  }
+  /// Measure the count values that value(i) returns, or every step-th of
+  /// them if approximate, scaled up.
+  template <typename At> void addValues(size_t count, At value) {
+    size_t step = approximate_ && count > sampleSize ? count / sampleSize : 1;
+    if (step == 1) {
+      for (size_t i = 0; i < count; ++i)
+        value(i).addMemoryUsage(*this);
+      return;
+    }
+    UsageWalk sample(true);
+    size_t measured = 0;
+    for (size_t i = 0; i < count; i += step, ++measured)
+      value(i).addMemoryUsage(sample);
+    MemoryUsage& part = sample.usage_;
+    usage_.nodes += part.nodes * count / measured;
+    usage_.containers += part.containers * count / measured;
+    usage_.keys += part.keys * count / measured;
+    usage_.strings += part.strings * count / measured;
+    usage_.comments += part.comments * count / measured;
+  }
+
+  static size_t nameBytes(const CZString& name) {
+    return name.isStaticString() ? 0 : name.length() + 1U;
+  }
+
+  MemoryUsage usage_;
+  bool approximate_;
+  std::unordered_set<const void*> seen_;
+};
+
+const size_t Value::UsageWalk::sampleSize;
+const size_t Value::UsageWalk::treeNodeHeader;
+
+void Value::ObjectValues::addUsage(UsageWalk& walk) const {
+  MemoryUsage& usage = walk.usage_;
+  usage.containers += sizeof(ObjectValues);
+  if (shape_) {
+    if (walk.counts(shape_, true)) {
+      usage.keys +=
+          sizeof(Shape) + shape_->names_.capacity() * sizeof(CZString);
+      for (size_t i = 0; i < shape_->names_.size(); ++i)
+        usage.keys += UsageWalk::nameBytes(shape_->names_[i]);
+    }
+    return;
+  }
+  if (tree_) {
+    usage.containers +=
+        sizeof(Tree) + tree_->size() * UsageWalk::treeNodeHeader;
+    usage.keys += tree_->size() * sizeof(CZString);
+    for (Tree::const_iterator it = tree_->begin(); it != tree_->end(); ++it)
+      usage.keys += UsageWalk::nameBytes(it->first);
+    if (index_)
+      usage.containers += index_->byteSize();
+    return;
+  }
+  usage.containers += (flat_.capacity() - flat_.size()) * sizeof(Member);
+  usage.keys += flat_.size() * sizeof(CZString);
+  for (Flat::const_iterator it = flat_.begin(); it != flat_.end(); ++it)
+    usage.keys += UsageWalk::nameBytes(it->first);
+}
+
+void Value::addMemoryUsage(UsageWalk& walk) const {
+  MemoryUsage& usage = walk.usage_;
+  usage.nodes += sizeof(Value);
+  if (Extra* extra = getExtra()) {
+    usage.nodes += sizeof(Extra);
+    if (extra->comments_) {
+      usage.nodes += numberOfCommentPlacement * sizeof(CommentInfo);
+      for (int comment = 0; comment < numberOfCommentPlacement; ++comment) {
+        if (char const* text = extra->comments_[comment].comment_)
+          usage.comments += strlen(text) + 1U;
+      }
+    }
+  }
+  switch (type_) {
+  case realValue:
+    if (allocated_ && walk.countsString(value_.string_))
+      usage.strings +=
+          sizeof(NumberText) +
+          reinterpret_cast<NumberText const*>(value_.string_)->length_ + 1U;
+    break;
+  case stringValue:
+    if (inlined_ || !allocated_ || !value_.string_ ||
+        !walk.countsString(value_.string_))
+      break;
+    if (raw_) {
+      RawString const* text =
+          reinterpret_cast<RawString const*>(value_.string_);
+      usage.strings += sizeof(RawString) + text->length_ + 1U;
+      if (char const* decoded = text->decoded_.load(std::memory_order_acquire))
+        usage.strings +=
+            sizeof(StringPrefix) +
+            reinterpret_cast<StringPrefix const*>(decoded)->length_ + 1U;
+    } else {
+      usage.strings +=
+          sizeof(StringPrefix) +
+          reinterpret_cast<StringPrefix const*>(value_.string_)->length_ + 1U;
+    }
+    break;
+  case arrayValue: {
+    ArrayValues const& elements = *value_.array_;
+    if (!walk.counts(&elements, elements.refs_.load(
+                                    std::memory_order_relaxed) > 1))
+      break;
+    usage.containers += sizeof(ArrayValues) +
+                        (elements.capacity() - elements.size()) * sizeof(Value);
+    if (ArrayValues::Packed const* packed = elements.packed_)
+      usage.containers += sizeof(ArrayValues::Packed) +
+                          packed->ints_.capacity() * sizeof(LargestInt) +
+                          packed->reals_.capacity() * sizeof(double);
+    // Packed numbers not boxed yet are not Values: only the boxed ones are.
+    walk.addValues(elements.size(), [&elements](size_t i) -> const Value& {
+      return elements[i];
+    });
+  } break;
+  case objectValue: {
+    ObjectValues& members = *value_.map_;
+    if (!walk.counts(&members,
+                     members.refs_.load(std::memory_order_relaxed) > 1))
+      break;
+    members.addUsage(walk);
+    ObjectValues::iterator it = members.begin();
+    size_t position = 0;
+    walk.addValues(members.size(), [&it, &position](size_t i) -> const Value& {
+      for (; position < i; ++position)
+        ++it;
+      return it.value();
+    });
+  } break;
+  default:
+    break;
+  }
+}
+
+Value::MemoryUsage Value::memoryUsage(bool approximate) const {
+  UsageWalk walk(approximate);
+  addMemoryUsage(walk);
+  return walk.usage_;
+}
+
+// deferredRelease
+// //////////////////////////////////////////////////////////////////
+
+namespace {
+// Queue of the values to destroy, and the thread destroying them. Never
+// destroyed, so that the thread may outlive static destructors.
+struct Reclaimer {
+  Reclaimer()
+      : limit_(1024), busy_(false), released_(0), releasedInPlace_(0),
+        reclaimedBytes_(0) {
+    std::thread(&Reclaimer::run, this).detach();
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      while (queue_.empty())
+        wake_.wait(lock);
+      Value value;
+      value.swap(queue_.front());
+      queue_.pop_front();
+      busy_ = true;
+      lock.unlock();
+      size_t bytes = value.memoryUsage(true).total() - sizeof(Value);
+      Value().swap(value);
+      lock.lock();
+      busy_ = false;
+      ++released_;
+      reclaimedBytes_ += bytes;
+      if (queue_.empty())
+        idle_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  std::deque<Value> queue_;
+  size_t limit_;
+  bool busy_;
+  LargestUInt released_;
+  LargestUInt releasedInPlace_;
+  LargestUInt reclaimedBytes_;
+};
+
+Reclaimer& reclaimer() {
+  static Reclaimer* instance = new Reclaimer();
+  return *instance;
+}
+} // namespace
+
+void deferredRelease(Value&& value) {
+  Value::SharedPayload* payload = 0;
+  if (value.type_ == arrayValue)
+    payload = value.value_.array_;
+  else if (value.type_ == objectValue)
+    payload = value.value_.map_;
+  if (!payload || payload->arena_ ||
+      payload->refs_.load(std::memory_order_acquire) != 1) {
+    Value().swap(value);
+    return;
+  }
+  Reclaimer& r = reclaimer();
+  {
+    std::lock_guard<std::mutex> lock(r.mutex_);
+    if (r.queue_.size() < r.limit_) {
+      r.queue_.push_back(Value());
+      r.queue_.back().swap(value);
+      r.wake_.notify_one();
+      return;
+    }
+    ++r.releasedInPlace_;
+  }
+  Value().swap(value);
+}
+
+void DeferredRelease::setQueueLimit(size_t limit) {
+  Reclaimer& r = reclaimer();
+  std::lock_guard<std::mutex> lock(r.mutex_);
+  r.limit_ = limit;
+}
+
+size_t DeferredRelease::queueLimit() {
+  Reclaimer& r = reclaimer();
+  std::lock_guard<std::mutex> lock(r.mutex_);
+  return r.limit_;
+}
+
+DeferredRelease::Stats DeferredRelease::stats() {
+  Reclaimer& r = reclaimer();
+  std::lock_guard<std::mutex> lock(r.mutex_);
+  Stats stats;
+  stats.queueDepth = r.queue_.size();
+  stats.released = r.released_;
+  stats.releasedInPlace = r.releasedInPlace_;
+  stats.reclaimedBytes = r.reclaimedBytes_;
+  return stats;
+}
+
+void DeferredRelease::flush() {
+  Reclaimer& r = reclaimer();
+  std::unique_lock<std::mutex> lock(r.mutex_);
+  while (!r.queue_.empty() || r.busy_)
+    r.idle_.wait(lock);
+}
+
 // class PathArgument
 // //////////////////////////////////////////////////////////////////
 
@@ -1599,16 +4031,29 @@ Value& Path::make(Value& root) const {
   Value* node = &root;
   for (Args::const_iterator it = args_.begin(); it != args_.end(); ++it) {
     const PathArgument& arg = *it;
+    // Missing nodes are created as the container the next argument needs,
+    // rather than as null values converted on the next step.
+    Args::const_iterator next = it + 1;
+    ValueType type = next == args_.end() ? nullValue
+                     : next->kind_ == PathArgument::kindIndex ? arrayValue
+                     : next->kind_ == PathArgument::kindKey ? objectValue
+                     : nullValue;
     if (arg.kind_ == PathArgument::kindIndex) {
       if (!node->isArray()) {
         // Error: node is not an array at position ...
       }
-      node = &((*node)[arg.index_]);
+      if (arg.index_ == node->size() && type != nullValue)
+        node = &node->append(Value(type));
+      else
+        node = &((*node)[arg.index_]);
     } else if (arg.kind_ == PathArgument::kindKey) {
       if (!node->isObject()) {
         // Error: node is not an object at position...
       }
-      node = &((*node)[arg.key_]);
+      if (node->isObject() && node->isMember(arg.key_))
+        node = &((*node)[arg.key_]);
+      else
+        node = &node->insert(arg.key_, Value(type));
     }
   }
   return *node;
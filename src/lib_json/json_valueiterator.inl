@@ -16,30 +16,39 @@ namespace Json {
 // //////////////////////////////////////////////////////////////////
 
 ValueIteratorBase::ValueIteratorBase()
-    : current_(), isNull_(true) {
+    : current_(), array_(0), index_(0), isNull_(true) {
 }
 
 ValueIteratorBase::ValueIteratorBase(
     const Value::ObjectValues::iterator& current)
-    : current_(current), isNull_(false) {}
+    : current_(current), array_(0), index_(0), isNull_(false) {}
+
+ValueIteratorBase::ValueIteratorBase(Value::ArrayValues* array,
+                                     ArrayIndex index)
+    : current_(), array_(array), index_(index), isNull_(false) {}
 
 Value& ValueIteratorBase::deref() const {
-  return current_->second;
+  if (array_)
+    return (*array_)[index_];
+  return current_.value();
 }
 
 void ValueIteratorBase::increment() {
-  ++current_;
+  if (array_)
+    ++index_;
+  else
+    ++current_;
 }
 
 void ValueIteratorBase::decrement() {
-  --current_;
+  if (array_)
+    --index_;
+  else
+    --current_;
 }
 
 ValueIteratorBase::difference_type
 ValueIteratorBase::computeDistance(const SelfType& other) const {
-#ifdef JSON_USE_CPPTL_SMALLMAP
-  return other.current_ - current_;
-#else
   // Iterator for null value are initialized using the default
   // constructor, which initialize current_ to the default
   // std::map::iterator. As begin() and end() are two instance
@@ -48,6 +57,9 @@ ValueIteratorBase::computeDistance(const SelfType& other) const {
   if (isNull_ && other.isNull_) {
     return 0;
   }
+  if (array_) {
+    return difference_type(other.index_) - difference_type(index_);
+  }
 
   // Usage of std::distance is not portable (does not compile with Sun Studio 12
   // RogueWave STL,
@@ -60,23 +72,29 @@ ValueIteratorBase::computeDistance(const SelfType& other) const {
     ++myDistance;
   }
   return myDistance;
-#endif
 }
 
 bool ValueIteratorBase::isEqual(const SelfType& other) const {
   if (isNull_) {
     return other.isNull_;
   }
+  if (array_ || other.array_) {
+    return array_ == other.array_ && index_ == other.index_;
+  }
   return current_ == other.current_;
 }
 
 void ValueIteratorBase::copy(const SelfType& other) {
   current_ = other.current_;
+  array_ = other.array_;
+  index_ = other.index_;
   isNull_ = other.isNull_;
 }
 
 Value ValueIteratorBase::key() const {
-  const Value::CZString czstring = (*current_).first;
+  if (array_)
+    return Value(index_);
+  const Value::CZString& czstring = current_.key();
   if (czstring.data()) {
     if (czstring.isStaticString())
       return Value(StaticString(czstring.data()));
@@ -86,7 +104,9 @@ Value ValueIteratorBase::key() const {
 }
 
 UInt ValueIteratorBase::index() const {
-  const Value::CZString czstring = (*current_).first;
+  if (array_)
+    return index_;
+  const Value::CZString& czstring = current_.key();
   if (!czstring.data())
     return czstring.index();
   return Value::UInt(-1);
@@ -101,17 +121,23 @@ JSONCPP_STRING ValueIteratorBase::name() const {
 }
 
 char const* ValueIteratorBase::memberName() const {
-  const char* cname = (*current_).first.data();
+  if (array_)
+    return "";
+  const char* cname = current_.key().data();
   return cname ? cname : "";
 }
 
 char const* ValueIteratorBase::memberName(char const** end) const {
-  const char* cname = (*current_).first.data();
+  if (array_) {
+    *end = NULL;
+    return NULL;
+  }
+  const char* cname = current_.key().data();
   if (!cname) {
     *end = NULL;
     return NULL;
   }
-  *end = cname + (*current_).first.length();
+  *end = cname + current_.key().length();
   return cname;
 }
 
@@ -129,6 +155,10 @@ ValueConstIterator::ValueConstIterator(
     const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
 
+ValueConstIterator::ValueConstIterator(Value::ArrayValues* array,
+                                       ArrayIndex index)
+    : ValueIteratorBase(array, index) {}
+
 ValueConstIterator::ValueConstIterator(ValueIterator const& other)
     : ValueIteratorBase(other) {}
 
@@ -151,6 +181,9 @@ ValueIterator::ValueIterator() {}
 ValueIterator::ValueIterator(const Value::ObjectValues::iterator& current)
     : ValueIteratorBase(current) {}
 
+ValueIterator::ValueIterator(Value::ArrayValues* array, ArrayIndex index)
+    : ValueIteratorBase(array, index) {}
+
 ValueIterator::ValueIterator(const ValueConstIterator& other)
     : ValueIteratorBase(other) {
   throwRuntimeError("ConstIterator to Iterator should never be allowed.");
@@ -317,6 +317,21 @@ static JSONCPP_STRING valueToQuotedStringN(const char* value, unsigned length) {
   return result;
 }
 
+// Element index of array. The elements of an array of packed numbers are
+// read into element rather than all boxed (see Value::getPackedReals()).
+static Value const& elementOf(Value const& array, ArrayIndex index,
+                              Value& element) {
+  double const* reals;
+  double const* realsEnd;
+  LargestInt const* ints;
+  LargestInt const* intsEnd;
+  if (array.getPackedReals(&reals, &realsEnd))
+    return element = reals[index];
+  if (array.getPackedInts(&ints, &intsEnd))
+    return element = ints[index];
+  return array[index];
+}
+
 // Class Writer
 // //////////////////////////////////////////////////////////////////
 Writer::~Writer() {}
@@ -354,14 +369,26 @@ void FastWriter::writeValue(const Value& value) {
   case uintValue:
     document_ += valueToString(value.asLargestUInt());
     break;
-  case realValue:
-    document_ += valueToString(value.asDouble());
+  case realValue: {
+    char const* begin;
+    char const* end;
+    if (value.getNumberText(&begin, &end))
+      document_.append(begin, end);
+    else
+      document_ += valueToString(value.asDouble());
     break;
+  }
   case stringValue:
   {
     // Is NULL possible for value.string_? No.
     char const* str;
     char const* end;
+    if (value.getRawString(&str, &end)) {
+      document_ += '"';
+      document_.append(str, end);
+      document_ += '"';
+      break;
+    }
     bool ok = value.getString(&str, &end);
     if (ok) document_ += valueToQuotedStringN(str, static_cast<unsigned>(end-str));
     break;
@@ -372,25 +399,26 @@ void FastWriter::writeValue(const Value& value) {
   case arrayValue: {
     document_ += '[';
     ArrayIndex size = value.size();
+    Value element;
     for (ArrayIndex index = 0; index < size; ++index) {
       if (index > 0)
         document_ += ',';
-      writeValue(value[index]);
+      writeValue(elementOf(value, index, element));
     }
     document_ += ']';
   } break;
   case objectValue: {
-    Value::Members members(value.getMemberNames());
     document_ += '{';
-    for (Value::Members::iterator it = members.begin(); it != members.end();
-         ++it) {
-      const JSONCPP_STRING& name = *it;
-      if (it != members.begin())
-        document_ += ',';
-      document_ += valueToQuotedStringN(name.data(), static_cast<unsigned>(name.length()));
-      document_ += yamlCompatiblityEnabled_ ? ": " : ":";
-      writeValue(value[name]);
-    }
+    bool first = true;
+    value.forEachMember(
+        [&](char const* name, unsigned length, Value const& childValue) {
+          if (!first)
+            document_ += ',';
+          first = false;
+          document_ += valueToQuotedStringN(name, length);
+          document_ += yamlCompatiblityEnabled_ ? ": " : ":";
+          writeValue(childValue);
+        });
     document_ += '}';
   } break;
   }
@@ -424,14 +452,24 @@ void StyledWriter::writeValue(const Value& value) {
   case uintValue:
     pushValue(valueToString(value.asLargestUInt()));
     break;
-  case realValue:
-    pushValue(valueToString(value.asDouble()));
+  case realValue: {
+    char const* begin;
+    char const* end;
+    if (value.getNumberText(&begin, &end))
+      pushValue(JSONCPP_STRING(begin, end));
+    else
+      pushValue(valueToString(value.asDouble()));
     break;
+  }
   case stringValue:
   {
     // Is NULL possible for value.string_? No.
     char const* str;
     char const* end;
+    if (value.getRawString(&str, &end)) {
+      pushValue('"' + JSONCPP_STRING(str, end) + '"');
+      break;
+    }
     bool ok = value.getString(&str, &end);
     if (ok) pushValue(valueToQuotedStringN(str, static_cast<unsigned>(end-str)));
     else pushValue("");
@@ -444,27 +482,22 @@ void StyledWriter::writeValue(const Value& value) {
     writeArrayValue(value);
     break;
   case objectValue: {
-    Value::Members members(value.getMemberNames());
-    if (members.empty())
+    ArrayIndex remaining = value.size();
+    if (remaining == 0)
       pushValue("{}");
     else {
       writeWithIndent("{");
       indent();
-      Value::Members::iterator it = members.begin();
-      for (;;) {
-        const JSONCPP_STRING& name = *it;
-        const Value& childValue = value[name];
-        writeCommentBeforeValue(childValue);
-        writeWithIndent(valueToQuotedString(name.c_str()));
-        document_ += " : ";
-        writeValue(childValue);
-        if (++it == members.end()) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        document_ += ',';
-        writeCommentAfterValueOnSameLine(childValue);
-      }
+      value.forEachMember(
+          [&](char const* name, unsigned, Value const& childValue) {
+            writeCommentBeforeValue(childValue);
+            writeWithIndent(valueToQuotedString(name));
+            document_ += " : ";
+            writeValue(childValue);
+            if (--remaining)
+              document_ += ',';
+            writeCommentAfterValueOnSameLine(childValue);
+          });
       unindent();
       writeWithIndent("}");
     }
@@ -474,6 +507,7 @@ void StyledWriter::writeValue(const Value& value) {
 
 void StyledWriter::writeArrayValue(const Value& value) {
   unsigned size = value.size();
+  Value element;
   if (size == 0)
     pushValue("[]");
   else {
@@ -484,7 +518,7 @@ void StyledWriter::writeArrayValue(const Value& value) {
       bool hasChildValue = !childValues_.empty();
       unsigned index = 0;
       for (;;) {
-        const Value& childValue = value[index];
+        const Value& childValue = elementOf(value, index, element);
         writeCommentBeforeValue(childValue);
         if (hasChildValue)
           writeWithIndent(childValues_[index]);
@@ -517,10 +551,11 @@ void StyledWriter::writeArrayValue(const Value& value) {
 
 bool StyledWriter::isMultineArray(const Value& value) {
   ArrayIndex const size = value.size();
+  Value element;
   bool isMultiLine = size * 3 >= rightMargin_;
   childValues_.clear();
   for (ArrayIndex index = 0; index < size && !isMultiLine; ++index) {
-    const Value& childValue = value[index];
+    const Value& childValue = elementOf(value, index, element);
     isMultiLine = ((childValue.isArray() || childValue.isObject()) &&
                         childValue.size() > 0);
   }
@@ -530,10 +565,10 @@ bool StyledWriter::isMultineArray(const Value& value) {
     addChildValues_ = true;
     ArrayIndex lineLength = 4 + (size - 1) * 2; // '[ ' + ', '*n + ' ]'
     for (ArrayIndex index = 0; index < size; ++index) {
-      if (hasCommentForValue(value[index])) {
+      if (hasCommentForValue(elementOf(value, index, element))) {
         isMultiLine = true;
       }
-      writeValue(value[index]);
+      writeValue(elementOf(value, index, element));
       lineLength += static_cast<ArrayIndex>(childValues_[index].length());
     }
     addChildValues_ = false;
@@ -641,14 +676,24 @@ void StyledStreamWriter::writeValue(const Value& value) {
   case uintValue:
     pushValue(valueToString(value.asLargestUInt()));
     break;
-  case realValue:
-    pushValue(valueToString(value.asDouble()));
+  case realValue: {
+    char const* begin;
+    char const* end;
+    if (value.getNumberText(&begin, &end))
+      pushValue(JSONCPP_STRING(begin, end));
+    else
+      pushValue(valueToString(value.asDouble()));
     break;
+  }
   case stringValue:
   {
     // Is NULL possible for value.string_? No.
     char const* str;
     char const* end;
+    if (value.getRawString(&str, &end)) {
+      pushValue('"' + JSONCPP_STRING(str, end) + '"');
+      break;
+    }
     bool ok = value.getString(&str, &end);
     if (ok) pushValue(valueToQuotedStringN(str, static_cast<unsigned>(end-str)));
     else pushValue("");
@@ -661,27 +706,22 @@ void StyledStreamWriter::writeValue(const Value& value) {
     writeArrayValue(value);
     break;
   case objectValue: {
-    Value::Members members(value.getMemberNames());
-    if (members.empty())
+    ArrayIndex remaining = value.size();
+    if (remaining == 0)
       pushValue("{}");
     else {
       writeWithIndent("{");
       indent();
-      Value::Members::iterator it = members.begin();
-      for (;;) {
-        const JSONCPP_STRING& name = *it;
-        const Value& childValue = value[name];
-        writeCommentBeforeValue(childValue);
-        writeWithIndent(valueToQuotedString(name.c_str()));
-        *document_ << " : ";
-        writeValue(childValue);
-        if (++it == members.end()) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        *document_ << ",";
-        writeCommentAfterValueOnSameLine(childValue);
-      }
+      value.forEachMember(
+          [&](char const* name, unsigned, Value const& childValue) {
+            writeCommentBeforeValue(childValue);
+            writeWithIndent(valueToQuotedString(name));
+            *document_ << " : ";
+            writeValue(childValue);
+            if (--remaining)
+              *document_ << ",";
+            writeCommentAfterValueOnSameLine(childValue);
+          });
       unindent();
       writeWithIndent("}");
     }
@@ -691,6 +731,7 @@ void StyledStreamWriter::writeValue(const Value& value) {
 
 void StyledStreamWriter::writeArrayValue(const Value& value) {
   unsigned size = value.size();
+  Value element;
   if (size == 0)
     pushValue("[]");
   else {
@@ -701,7 +742,7 @@ void StyledStreamWriter::writeArrayValue(const Value& value) {
       bool hasChildValue = !childValues_.empty();
       unsigned index = 0;
       for (;;) {
-        const Value& childValue = value[index];
+        const Value& childValue = elementOf(value, index, element);
         writeCommentBeforeValue(childValue);
         if (hasChildValue)
           writeWithIndent(childValues_[index]);
@@ -736,10 +777,11 @@ void StyledStreamWriter::writeArrayValue(const Value& value) {
 
 bool StyledStreamWriter::isMultineArray(const Value& value) {
   ArrayIndex const size = value.size();
+  Value element;
   bool isMultiLine = size * 3 >= rightMargin_;
   childValues_.clear();
   for (ArrayIndex index = 0; index < size && !isMultiLine; ++index) {
-    const Value& childValue = value[index];
+    const Value& childValue = elementOf(value, index, element);
     isMultiLine = ((childValue.isArray() || childValue.isObject()) &&
                         childValue.size() > 0);
   }
@@ -749,10 +791,10 @@ bool StyledStreamWriter::isMultineArray(const Value& value) {
     addChildValues_ = true;
     ArrayIndex lineLength = 4 + (size - 1) * 2; // '[ ' + ', '*n + ' ]'
     for (ArrayIndex index = 0; index < size; ++index) {
-      if (hasCommentForValue(value[index])) {
+      if (hasCommentForValue(elementOf(value, index, element))) {
         isMultiLine = true;
       }
-      writeValue(value[index]);
+      writeValue(elementOf(value, index, element));
       lineLength += static_cast<ArrayIndex>(childValues_[index].length());
     }
     addChildValues_ = false;
@@ -922,14 +964,24 @@ void BuiltStyledStreamWriter::writeValue(Value const& value) {
   case uintValue:
     pushValue(valueToString(value.asLargestUInt()));
     break;
-  case realValue:
-    pushValue(valueToString(value.asDouble(), useSpecialFloats_, precision_));
+  case realValue: {
+    char const* begin;
+    char const* end;
+    if (value.getNumberText(&begin, &end))
+      pushValue(JSONCPP_STRING(begin, end));
+    else
+      pushValue(valueToString(value.asDouble(), useSpecialFloats_, precision_));
     break;
+  }
   case stringValue:
   {
     // Is NULL is possible for value.string_? No.
     char const* str;
     char const* end;
+    if (value.getRawString(&str, &end)) {
+      pushValue('"' + JSONCPP_STRING(str, end) + '"');
+      break;
+    }
     bool ok = value.getString(&str, &end);
     if (ok) pushValue(valueToQuotedStringN(str, static_cast<unsigned>(end-str)));
     else pushValue("");
@@ -942,27 +994,22 @@ void BuiltStyledStreamWriter::writeValue(Value const& value) {
     writeArrayValue(value);
     break;
   case objectValue: {
-    Value::Members members(value.getMemberNames());
-    if (members.empty())
+    ArrayIndex remaining = value.size();
+    if (remaining == 0)
       pushValue("{}");
     else {
       writeWithIndent("{");
       indent();
-      Value::Members::iterator it = members.begin();
-      for (;;) {
-        JSONCPP_STRING const& name = *it;
-        Value const& childValue = value[name];
-        writeCommentBeforeValue(childValue);
-        writeWithIndent(valueToQuotedStringN(name.data(), static_cast<unsigned>(name.length())));
-        *sout_ << colonSymbol_;
-        writeValue(childValue);
-        if (++it == members.end()) {
-          writeCommentAfterValueOnSameLine(childValue);
-          break;
-        }
-        *sout_ << ",";
-        writeCommentAfterValueOnSameLine(childValue);
-      }
+      value.forEachMember(
+          [&](char const* name, unsigned length, Value const& childValue) {
+            writeCommentBeforeValue(childValue);
+            writeWithIndent(valueToQuotedStringN(name, length));
+            *sout_ << colonSymbol_;
+            writeValue(childValue);
+            if (--remaining)
+              *sout_ << ",";
+            writeCommentAfterValueOnSameLine(childValue);
+          });
       unindent();
       writeWithIndent("}");
     }
@@ -972,6 +1019,7 @@ void BuiltStyledStreamWriter::writeValue(Value const& value) {
 
 void BuiltStyledStreamWriter::writeArrayValue(Value const& value) {
   unsigned size = value.size();
+  Value element;
   if (size == 0)
     pushValue("[]");
   else {
@@ -982,7 +1030,7 @@ void BuiltStyledStreamWriter::writeArrayValue(Value const& value) {
       bool hasChildValue = !childValues_.empty();
       unsigned index = 0;
       for (;;) {
-        Value const& childValue = value[index];
+        Value const& childValue = elementOf(value, index, element);
         writeCommentBeforeValue(childValue);
         if (hasChildValue)
           writeWithIndent(childValues_[index]);
@@ -1019,10 +1067,11 @@ void BuiltStyledStreamWriter::writeArrayValue(Value const& value) {
 
 bool BuiltStyledStreamWriter::isMultineArray(Value const& value) {
   ArrayIndex const size = value.size();
+  Value element;
   bool isMultiLine = size * 3 >= rightMargin_;
   childValues_.clear();
   for (ArrayIndex index = 0; index < size && !isMultiLine; ++index) {
-    Value const& childValue = value[index];
+    Value const& childValue = elementOf(value, index, element);
     isMultiLine = ((childValue.isArray() || childValue.isObject()) &&
                         childValue.size() > 0);
   }
@@ -1032,10 +1081,10 @@ bool BuiltStyledStreamWriter::isMultineArray(Value const& value) {
     addChildValues_ = true;
     ArrayIndex lineLength = 4 + (size - 1) * 2; // '[ ' + ', '*n + ' ]'
     for (ArrayIndex index = 0; index < size; ++index) {
-      if (hasCommentForValue(value[index])) {
+      if (hasCommentForValue(elementOf(value, index, element))) {
         isMultiLine = true;
       }
-      writeValue(value[index]);
+      writeValue(elementOf(value, index, element));
       lineLength += static_cast<ArrayIndex>(childValues_[index].length());
     }
     addChildValues_ = false;
@@ -6,11 +6,14 @@
 #include "jsontest.h"
 #include <json/config.h>
 #include <json/json.h>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <limits>
 #include <sstream>
 #include <string>
 #include <iomanip>
+#include <unordered_set>
 
 // Make numeric limits more convenient to talk about.
 // Assumes int type in 32 bits.
@@ -216,6 +219,99 @@ JSONTEST_FIXTURE(ValueTest, objects) {
   JSONTEST_ASSERT_EQUAL(false, did);
 }
 
+JSONTEST_FIXTURE(ValueTest, objectGrowAndShrink) {
+  // Members are inserted in reverse order, and the object goes from the
+  // flat representation to the tree one half-way.
+  Json::Value object;
+  Json::Value small;
+  for (int i = 40; i-- > 0;) {
+    char name[16];
+    snprintf(name, sizeof(name), "k%02d", i);
+    object[name] = i;
+    if (i == 30)
+      small = object;
+  }
+  JSONTEST_ASSERT_EQUAL(Json::objectValue, object.type());
+  JSONTEST_ASSERT_EQUAL(40u, object.size());
+  JSONTEST_ASSERT_EQUAL(10u, small.size());
+  JSONTEST_ASSERT_EQUAL(Json::Value(7), object["k07"]);
+  JSONTEST_ASSERT_EQUAL(Json::Value(35), small["k35"]);
+  JSONTEST_ASSERT(!small.isMember("k29"));
+
+  int expected = 0;
+  for (Json::Value::const_iterator it = object.begin(); it != object.end();
+       ++it, ++expected) {
+    JSONTEST_ASSERT_EQUAL(Json::Value(expected), *it);
+    JSONTEST_ASSERT_EQUAL(object.getMemberNames()[expected], it.name());
+  }
+  JSONTEST_ASSERT_EQUAL(40, object.end() - object.begin());
+
+  Json::Value got;
+  JSONTEST_ASSERT(object.removeMember("k20", &got));
+  JSONTEST_ASSERT_EQUAL(Json::Value(20), got);
+  JSONTEST_ASSERT(small.removeMember("k39", &got));
+  JSONTEST_ASSERT_EQUAL(Json::Value(39), got);
+  JSONTEST_ASSERT_EQUAL(39u, object.size());
+  JSONTEST_ASSERT_EQUAL(9u, small.size());
+  JSONTEST_ASSERT(!object.isMember("k20"));
+
+  // Flat and tree objects compare by content.
+  Json::Value copy(object);
+  for (int i = 0; i < 30; ++i) {
+    char name[16];
+    snprintf(name, sizeof(name), "k%02d", i);
+    copy.removeMember(name);
+  }
+  copy.removeMember("k39");
+  JSONTEST_ASSERT_EQUAL(small, copy);
+  JSONTEST_ASSERT(small < object);
+  copy.clear();
+  JSONTEST_ASSERT(copy.empty());
+}
+
+JSONTEST_FIXTURE(ValueTest, largeObjects) {
+  // Large enough for the hash index to be built and grown a few times.
+  const int count = 1000;
+  Json::Value object;
+  for (int i = 0; i < count; ++i) {
+    char name[16];
+    snprintf(name, sizeof(name), "m%d", i);
+    object[name] = i;
+  }
+  JSONTEST_ASSERT_EQUAL(Json::ArrayIndex(count), object.size());
+
+  // Remove every third member, then put some of them back.
+  for (int i = 0; i < count; i += 3) {
+    char name[16];
+    snprintf(name, sizeof(name), "m%d", i);
+    Json::Value got;
+    JSONTEST_ASSERT(object.removeMember(name, &got));
+    JSONTEST_ASSERT_EQUAL(Json::Value(i), got);
+  }
+  for (int i = 0; i < count; i += 6) {
+    char name[16];
+    snprintf(name, sizeof(name), "m%d", i);
+    object[name] = -i;
+  }
+
+  const Json::Value copy(object);
+  for (int i = 0; i < count; ++i) {
+    char name[16];
+    snprintf(name, sizeof(name), "m%d", i);
+    Json::Value expected = i % 6 == 0 ? Json::Value(-i)
+                                      : i % 3 == 0 ? Json::Value() : Json::Value(i);
+    JSONTEST_ASSERT_EQUAL(expected, copy[name]);
+    JSONTEST_ASSERT_EQUAL(!expected.isNull(), object.isMember(name));
+  }
+  JSONTEST_ASSERT(copy == object);
+
+  // Iteration stays in name order.
+  Json::Value::Members names = copy.getMemberNames();
+  JSONTEST_ASSERT_EQUAL(names.size(), size_t(copy.end() - copy.begin()));
+  for (size_t i = 1; i < names.size(); ++i)
+    JSONTEST_ASSERT(names[i - 1] < names[i]);
+}
+
 JSONTEST_FIXTURE(ValueTest, arrays) {
   const unsigned int index0 = 0;
 
@@ -276,6 +372,102 @@ JSONTEST_FIXTURE(ValueTest, arrayIssue252)
   //JSONTEST_ASSERT_EQUAL(5, root["array"].size());
 }
 
+JSONTEST_FIXTURE(ValueTest, arrayGrowAndShrink) {
+  Json::Value array;
+  for (int i = 0; i < 100; ++i)
+    JSONTEST_ASSERT_EQUAL(Json::Value(i), array.append(i));
+  JSONTEST_ASSERT_EQUAL(Json::arrayValue, array.type());
+  JSONTEST_ASSERT_EQUAL(100u, array.size());
+
+  Json::Value got;
+  JSONTEST_ASSERT(array.removeIndex(10, &got));
+  JSONTEST_ASSERT_EQUAL(Json::Value(10), got);
+  JSONTEST_ASSERT_EQUAL(99u, array.size());
+  JSONTEST_ASSERT_EQUAL(Json::Value(11), array[10]);
+  JSONTEST_ASSERT_EQUAL(Json::Value(99), array[98]);
+
+  array.resize(20);
+  JSONTEST_ASSERT_EQUAL(20u, array.size());
+  JSONTEST_ASSERT_EQUAL(Json::Value(20), array[19]);
+  const Json::Value& constArray = array;
+  JSONTEST_ASSERT_EQUAL(Json::Value(), constArray[20]);
+  JSONTEST_ASSERT_EQUAL(20u, array.size());
+
+  Json::ArrayIndex expected = 0;
+  for (Json::Value::const_iterator it = constArray.begin();
+       it != constArray.end(); ++it, ++expected) {
+    JSONTEST_ASSERT_EQUAL(expected, it.index());
+    JSONTEST_ASSERT_EQUAL(constArray[expected], *it);
+  }
+  JSONTEST_ASSERT_EQUAL(20, constArray.end() - constArray.begin());
+
+  Json::Value copy(array);
+  JSONTEST_ASSERT(copy == array);
+  copy[25] = true;
+  JSONTEST_ASSERT_EQUAL(26u, copy.size());
+  JSONTEST_ASSERT(array < copy);
+}
+
+JSONTEST_FIXTURE(ValueTest, arrayBulkMutations) {
+  Json::Value array;
+  JSONTEST_ASSERT_EQUAL(0u, array.eraseIf([](const Json::Value&) {
+    return true;
+  }));
+  JSONTEST_ASSERT(!array.erase(0, 0));
+  JSONTEST_ASSERT(!array.insert(1, 0));
+  JSONTEST_ASSERT(array.insert(0, "first"));
+  JSONTEST_ASSERT_EQUAL(Json::arrayValue, array.type());
+  for (int i = 0; i < 20; ++i)
+    array.append(i);
+
+  Json::Value copy = array;
+  JSONTEST_ASSERT_EQUAL(10u, array.eraseIf([](const Json::Value& v) {
+    return v.isInt() && v.asInt() % 2 == 1;
+  }));
+  JSONTEST_ASSERT_EQUAL(11u, array.size());
+  JSONTEST_ASSERT_EQUAL(Json::Value("first"), array[0]);
+  for (int i = 0; i < 10; ++i)
+    JSONTEST_ASSERT_EQUAL(Json::Value(2 * i), array[i + 1]);
+  JSONTEST_ASSERT_EQUAL(21u, copy.size()); // copies are left alone
+
+  JSONTEST_ASSERT(!array.erase(5, 4));
+  JSONTEST_ASSERT(!array.erase(5, 12));
+  JSONTEST_ASSERT(array.erase(1, 4));
+  JSONTEST_ASSERT_EQUAL(8u, array.size());
+  JSONTEST_ASSERT_EQUAL(Json::Value(6), array[1]);
+
+  Json::Value object(Json::objectValue);
+  object["name"] = "a string too long to be inlined";
+  JSONTEST_ASSERT(array.insert(1, std::move(object)));
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, object.type());
+  JSONTEST_ASSERT(array.insert(array.size(), array[1]));
+  JSONTEST_ASSERT_EQUAL(10u, array.size());
+  JSONTEST_ASSERT_EQUAL(array[1], array[9]);
+  JSONTEST_ASSERT_EQUAL(Json::Value(6), array[2]);
+
+  // The element moved may be one of the array, with room to grow in place.
+  Json::Value elements(Json::arrayValue);
+  elements.reserve(8);
+  for (int i = 0; i < 4; ++i)
+    elements.append("element number " + std::to_string(i));
+  JSONTEST_ASSERT(elements.insert(0u, std::move(elements[2])));
+  JSONTEST_ASSERT_EQUAL(5u, elements.size());
+  JSONTEST_ASSERT_EQUAL(Json::Value("element number 2"), elements[0]);
+  JSONTEST_ASSERT_EQUAL(Json::Value("element number 0"), elements[1]);
+  JSONTEST_ASSERT_EQUAL(Json::Value("element number 1"), elements[2]);
+  JSONTEST_ASSERT(elements[3].isNull());
+  JSONTEST_ASSERT_EQUAL(Json::Value("element number 3"), elements[4]);
+
+  array.truncate(20);
+  JSONTEST_ASSERT_EQUAL(10u, array.size());
+  array.truncate(2);
+  JSONTEST_ASSERT_EQUAL(2u, array.size());
+  JSONTEST_ASSERT_EQUAL(Json::Value("first"), array[0]);
+  array.truncate(0);
+  JSONTEST_ASSERT_EQUAL(Json::arrayValue, array.type());
+  JSONTEST_ASSERT_EQUAL(0u, array.size());
+}
+
 JSONTEST_FIXTURE(ValueTest, null) {
   JSONTEST_ASSERT_EQUAL(Json::nullValue, null_.type());
 
@@ -332,6 +524,40 @@ JSONTEST_FIXTURE(ValueTest, strings) {
   JSONTEST_ASSERT_STRING_EQUAL("a", string1_.asCString());
 }
 
+JSONTEST_FIXTURE(ValueTest, shortStrings) {
+  // Strings of up to 7 chars are stored inline; check both sides of that.
+  char const* const texts[] = { "", "abcdefg", "abcdefgh", "abcdefghijklmnop" };
+  for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+    JSONCPP_STRING text(texts[i]);
+    Json::Value value(text);
+    JSONTEST_ASSERT_EQUAL(Json::stringValue, value.type());
+    JSONTEST_ASSERT_STRING_EQUAL(text, value.asString());
+    JSONTEST_ASSERT_STRING_EQUAL(text, value.asCString());
+    char const* begin;
+    char const* end;
+    JSONTEST_ASSERT(value.getString(&begin, &end));
+    JSONTEST_ASSERT_EQUAL(text.length(), size_t(end - begin));
+
+    Json::Value copy(value);
+    JSONTEST_ASSERT_EQUAL(value, copy);
+    Json::Value moved;
+    moved.swap(copy);
+    JSONTEST_ASSERT(copy.isNull());
+    JSONTEST_ASSERT_STRING_EQUAL(text, moved.asString());
+    JSONTEST_ASSERT_EQUAL(0, moved.compare(Json::Value(texts[i])));
+    JSONTEST_ASSERT(text.empty() == (moved < Json::Value("abc")));
+  }
+
+  // Embedded zeroes are kept, and take part in comparisons.
+  char const binary[] = "a\0b";
+  Json::Value zeroes(binary, binary + 3);
+  JSONTEST_ASSERT_STRING_EQUAL(JSONCPP_STRING(binary, 3), zeroes.asString());
+  JSONTEST_ASSERT(Json::Value("a") < zeroes);
+  JSONTEST_ASSERT(Json::Value("a") != zeroes);
+  JSONTEST_ASSERT_STRING_EQUAL("\"a\\u0000b\"\n",
+                               Json::FastWriter().write(zeroes));
+}
+
 JSONTEST_FIXTURE(ValueTest, bools) {
   JSONTEST_ASSERT_EQUAL(Json::booleanValue, false_.type());
 
@@ -1535,6 +1761,560 @@ JSONTEST_FIXTURE(ValueTest, offsetAccessors) {
   JSONTEST_ASSERT(y.getOffsetLimit() == 0);
 }
 
+JSONTEST_FIXTURE(ValueTest, compactLayout) {
+  // Comments and offsets are out of line.
+  JSONTEST_ASSERT_EQUAL(16u, sizeof(Json::Value));
+
+  Json::Value array(Json::arrayValue);
+  for (int i = 0; i < 300; ++i) {
+    Json::Value& item = array.append(i);
+    if (i % 2)
+      item.setComment(JSONCPP_STRING("// odd"), Json::commentBefore);
+    item.setOffsetStart(i);
+    item.setOffsetLimit(i + 1);
+  }
+  Json::Value copy(array);
+  array.clear();
+  for (int i = 0; i < 300; ++i) {
+    JSONTEST_ASSERT_EQUAL(i % 2 == 1, copy[i].hasComment(Json::commentBefore));
+    JSONTEST_ASSERT_EQUAL(i, copy[i].getOffsetStart());
+    JSONTEST_ASSERT_EQUAL(i + 1, copy[i].getOffsetLimit());
+  }
+  JSONTEST_ASSERT_STRING_EQUAL("// odd", copy[1].getComment(Json::commentBefore));
+
+  // Swapping the payload leaves comments and offsets in place.
+  Json::Value other("other");
+  other.swapPayload(copy[1]);
+  JSONTEST_ASSERT_EQUAL(Json::Value("other"), copy[1]);
+  JSONTEST_ASSERT(copy[1].hasComment(Json::commentBefore));
+  JSONTEST_ASSERT_EQUAL(1, copy[1].getOffsetStart());
+  JSONTEST_ASSERT(!other.hasComment(Json::commentBefore));
+  JSONTEST_ASSERT_EQUAL(0, other.getOffsetStart());
+
+  // Records given back, even all of them, are handed out again cleared.
+  copy.clear();
+  other = Json::Value();
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < 3000; ++i)
+      array.append(i).setOffsetStart(round ? i : 0);
+    for (int i = 0; i < 3000; ++i) {
+      JSONTEST_ASSERT_EQUAL(round ? i : 0, array[i].getOffsetStart());
+      JSONTEST_ASSERT_EQUAL(0, array[i].getOffsetLimit());
+    }
+    array.clear();
+  }
+}
+
+JSONTEST_FIXTURE(ValueTest, copyOnWrite) {
+  Json::CharReaderBuilder b;
+  Json::CharReader* reader(b.newCharReader());
+  Json::Value root;
+  char const doc[] =
+      "{ \"name\" : \"a string too long to be inline\", "
+      "\"list\" : [1, 2, 3], \"nested\" : { \"x\" : 1 } }";
+  JSONTEST_ASSERT(reader->parse(doc, doc + std::strlen(doc), &root, NULL));
+  delete reader;
+
+  // Copies of a parsed document share its payloads.
+  Json::Value copy(root);
+  Json::Value const& croot = root;
+  Json::Value const& ccopy = copy;
+  JSONTEST_ASSERT(&croot["list"] == &ccopy["list"]);
+  JSONTEST_ASSERT(croot["name"].asCString() == ccopy["name"].asCString());
+
+  // Modifying a copy detaches it, one level at a time.
+  copy["nested"]["x"] = 2;
+  JSONTEST_ASSERT(&croot["list"] != &ccopy["list"]);
+  JSONTEST_ASSERT_EQUAL(1, croot["nested"]["x"].asInt());
+  JSONTEST_ASSERT_EQUAL(2, ccopy["nested"]["x"].asInt());
+  JSONTEST_ASSERT(croot["name"].asCString() == ccopy["name"].asCString());
+  JSONTEST_ASSERT(croot["list"] == ccopy["list"]);
+
+  Json::Value removed;
+  Json::Value other(root);
+  JSONTEST_ASSERT(other["list"].removeIndex(0, &removed));
+  JSONTEST_ASSERT(other.removeMember("name", &removed));
+  JSONTEST_ASSERT_EQUAL(3u, croot["list"].size());
+  JSONTEST_ASSERT(croot.isMember("name"));
+  other = root;
+  other["list"].clear();
+  other["list"].resize(1);
+  JSONTEST_ASSERT_EQUAL(3u, croot["list"].size());
+  JSONTEST_ASSERT_EQUAL(3, croot["list"][2].asInt());
+
+  // A mutable reference into a value pins it: later copies do not alias
+  // the referenced element.
+  Json::Value& x = root["nested"]["x"];
+  Json::Value snapshot(root);
+  x = 3;
+  JSONTEST_ASSERT_EQUAL(1, snapshot["nested"]["x"].asInt());
+  JSONTEST_ASSERT_EQUAL(3, root["nested"]["x"].asInt());
+  for (Json::Value::iterator it = root["list"].begin();
+       it != root["list"].end(); ++it) {
+    Json::Value shared(root);
+    *it = 0;
+    JSONTEST_ASSERT(shared["list"] != root["list"]);
+  }
+}
+
+JSONTEST_FIXTURE(ValueTest, moveInsertion) {
+  Json::Value list;
+  Json::Value inner(Json::arrayValue);
+  Json::Value const& first = inner.append(1);
+  JSONTEST_ASSERT(&list.append(std::move(inner))[0] == &first);
+  list.emplace_back("text");
+  list.emplace_back(Json::objectValue);
+  list.emplace_back(3u);
+  JSONTEST_ASSERT_EQUAL(4u, list.size());
+  JSONTEST_ASSERT_STRING_EQUAL("text", list[1].asString());
+  JSONTEST_ASSERT(list[2].isObject());
+  JSONTEST_ASSERT_EQUAL(Json::uintValue, list[3].type());
+
+  Json::Value object;
+  Json::Value& member = object.insert("key", Json::Value(1));
+  JSONTEST_ASSERT_EQUAL(1, member.asInt());
+  JSONTEST_ASSERT_EQUAL(2, object.insert("key", Json::Value(2)).asInt());
+  JSONTEST_ASSERT_EQUAL(1u, object.size());
+  JSONTEST_ASSERT_EQUAL(2, object["key"].asInt());
+  char const name[] = "a\0b";
+  object.insert(name, name + 3, std::move(list));
+  JSONTEST_ASSERT(list.isNull());
+  JSONTEST_ASSERT(object.find(name, name + 3) != NULL);
+  JSONTEST_ASSERT_EQUAL(4u, object.find(name, name + 3)->size());
+  static const Json::StaticString code("code");
+  object.insert(code, Json::Value(1234));
+  Json::Value::const_iterator it = object.begin();
+  char const* end = 0;
+  ++it; // "a\0b" < "code" < "key"
+  JSONTEST_ASSERT(it.memberName(&end) == code.c_str());
+
+  // The argument may be a member of the object inserted into, small or not.
+  Json::Value small;
+  small["b"] = "a string too long to be inlined";
+  small.insert("a", std::move(small["b"]));
+  JSONTEST_ASSERT_STRING_EQUAL("a string too long to be inlined",
+                               small["a"].asString());
+  JSONTEST_ASSERT(small["b"].isNull());
+  Json::Value large;
+  for (int i = 0; i < 16; ++i)
+    large[JSONCPP_STRING(1, char('b' + i))] = i;
+  large.insert("a", std::move(large["b"]));
+  JSONTEST_ASSERT_EQUAL(17u, large.size());
+  JSONTEST_ASSERT_EQUAL(0, large["a"].asInt());
+  JSONTEST_ASSERT(large["b"].isNull());
+
+  Json::Value root;
+  Json::Path("a[0].b").make(root) = 5;
+  JSONTEST_ASSERT(root["a"].isArray());
+  JSONTEST_ASSERT(root["a"][0].isObject());
+  JSONTEST_ASSERT_EQUAL(5, root["a"][0]["b"].asInt());
+  Json::Path("a[0].c").make(root) = 6;
+  JSONTEST_ASSERT_EQUAL(1u, root["a"].size());
+  JSONTEST_ASSERT_EQUAL(2u, root["a"][0].size());
+}
+
+JSONTEST_FIXTURE(ValueTest, reserve) {
+  Json::Value array;
+  array.reserve(100);
+  JSONTEST_ASSERT_EQUAL(Json::arrayValue, array.type());
+  JSONTEST_ASSERT_EQUAL(0u, array.size());
+  Json::Value const* first = &array.append(0);
+  for (int i = 1; i < 100; ++i)
+    array.append(i);
+  // No growth step moved the elements.
+  JSONTEST_ASSERT(first == &array[0]);
+  array.resize(10);
+  array.shrinkToFit();
+  JSONTEST_ASSERT_EQUAL(10u, array.size());
+  JSONTEST_ASSERT_EQUAL(9, array[9].asInt());
+
+  char name[16];
+  for (Json::ArrayIndex count = 10; count <= 100; count += 90) {
+    Json::Value object(Json::objectValue);
+    object.reserve(count);
+    for (Json::ArrayIndex i = 0; i < count; ++i) {
+      snprintf(name, sizeof(name), "k%02u", i);
+      object[name] = i;
+    }
+    Json::Value copy(object);
+    copy.reserve(2 * count);
+    copy["extra"] = true;
+    object.shrinkToFit();
+    JSONTEST_ASSERT_EQUAL(count, object.size());
+    JSONTEST_ASSERT_EQUAL(count + 1, copy.size());
+    JSONTEST_ASSERT_EQUAL(count - 1, object[name].asUInt());
+    JSONTEST_ASSERT(!object.isMember("extra"));
+  }
+}
+
+JSONTEST_FIXTURE(ValueTest, keyLookups) {
+  Json::Key const id("id");
+  JSONTEST_ASSERT(!id.isInterned()); // the KeyPool is disabled
+  JSONTEST_ASSERT_EQUAL(2u, id.length());
+  Json::KeyPool::setEnabled(true);
+  Json::Key const pooled("id");
+  Json::KeyPool::setEnabled(false);
+  JSONTEST_ASSERT(pooled.isInterned());
+  JSONTEST_ASSERT_EQUAL(id.hash(), pooled.hash());
+  JSONTEST_ASSERT_EQUAL(Json::Key(JSONCPP_STRING("id")).hash(), id.hash());
+
+  char name[16];
+  for (int count = 4; count <= 200; count *= 50) {
+    Json::Value object;
+    for (int i = 0; i < count; ++i) {
+      snprintf(name, sizeof(name), "k%03d", i);
+      object[name] = i;
+    }
+    Json::Value const& cobject = object;
+    JSONTEST_ASSERT(!cobject.isMember(id));
+    JSONTEST_ASSERT(cobject.find(id) == NULL);
+    JSONTEST_ASSERT(cobject[id].isNull());
+    JSONTEST_ASSERT_EQUAL(7, cobject.get(id, 7).asInt());
+    object[id] = 42;
+    JSONTEST_ASSERT_EQUAL(42, cobject[id].asInt());
+    JSONTEST_ASSERT_EQUAL(42, cobject["id"].asInt());
+    JSONTEST_ASSERT_EQUAL(count - 1, cobject[Json::Key(name)].asInt());
+
+    Json::Value copy(object);
+    JSONTEST_ASSERT_EQUAL(42, copy.removeMember(id).asInt());
+    Json::Value removed;
+    JSONTEST_ASSERT(!copy.removeMember(id, &removed));
+    JSONTEST_ASSERT(copy.removeMember(Json::Key(name), &removed));
+    JSONTEST_ASSERT_EQUAL(count - 1, removed.asInt());
+    JSONTEST_ASSERT_EQUAL(static_cast<Json::ArrayIndex>(count) - 1, copy.size());
+    JSONTEST_ASSERT(cobject.isMember(id));
+  }
+
+  // Names that cannot be pooled are kept by the Key itself.
+  char const zero[] = "a\0b";
+  Json::KeyPool::setEnabled(true);
+  Json::Key key(zero, zero + 3);
+  Json::KeyPool::setEnabled(false);
+  JSONTEST_ASSERT(!key.isInterned());
+  Json::Key copy(key);
+  Json::Key assigned(id);
+  assigned = key;
+  JSONTEST_ASSERT(copy.data() != key.data());
+  JSONTEST_ASSERT_EQUAL(0, memcmp(assigned.data(), zero, 4));
+  Json::Value object;
+  object[assigned] = true;
+  JSONTEST_ASSERT(object.isMember(zero, zero + 3));
+  JSONTEST_ASSERT(object.isMember(copy));
+}
+
+JSONTEST_FIXTURE(ValueTest, forEachMember) {
+  Json::Value object;
+  char const zero[] = "a\0b";
+  object["b"] = 2;
+  object["a"] = 1;
+  object[JSONCPP_STRING(zero, 3)] = 3;
+  JSONCPP_STRING names;
+  int sum = 0;
+  object.forEachMember(
+      [&](char const* name, unsigned length, Json::Value const& value) {
+        JSONTEST_ASSERT_EQUAL(0, name[length]);
+        names.append(name, length).append(",");
+        sum += value.asInt();
+        JSONTEST_ASSERT(&value == object.find(name, name + length));
+      });
+  JSONTEST_ASSERT_STRING_EQUAL(JSONCPP_STRING("a,a\0b,b,", 8), names);
+  JSONTEST_ASSERT_EQUAL(6, sum);
+
+  int calls = 0;
+  Json::Value().forEachMember(
+      [&](char const*, unsigned, Json::Value const&) { ++calls; });
+  Json::Value(Json::arrayValue).forEachMember(
+      [&](char const*, unsigned, Json::Value const&) { ++calls; });
+  JSONTEST_ASSERT_EQUAL(0, calls);
+}
+
+JSONTEST_FIXTURE(ValueTest, mergePatch) {
+  Json::CharReaderBuilder b;
+  Json::CharReader* reader(b.newCharReader());
+  auto parse = [reader](const std::string& doc) {
+    Json::Value value;
+    reader->parse(doc.data(), doc.data() + doc.size(), &value, nullptr);
+    return value;
+  };
+  // The examples of RFC 7396, appendix A.
+  static const char* const cases[][3] = {
+      {"{\"a\":\"b\"}", "{\"a\":\"c\"}", "{\"a\":\"c\"}"},
+      {"{\"a\":\"b\"}", "{\"b\":\"c\"}", "{\"a\":\"b\",\"b\":\"c\"}"},
+      {"{\"a\":\"b\"}", "{\"a\":null}", "{}"},
+      {"{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}", "{\"b\":\"c\"}"},
+      {"{\"a\":[\"b\"]}", "{\"a\":\"c\"}", "{\"a\":\"c\"}"},
+      {"{\"a\":\"c\"}", "{\"a\":[\"b\"]}", "{\"a\":[\"b\"]}"},
+      {"{\"a\":{\"b\":\"c\"}}", "{\"a\":{\"b\":\"d\",\"c\":null}}",
+       "{\"a\":{\"b\":\"d\"}}"},
+      {"{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}", "{\"a\":[1]}"},
+      {"[\"a\",\"b\"]", "[\"c\",\"d\"]", "[\"c\",\"d\"]"},
+      {"{\"a\":\"b\"}", "[\"c\"]", "[\"c\"]"},
+      {"{\"a\":\"foo\"}", "null", "null"},
+      {"{\"a\":\"foo\"}", "\"bar\"", "\"bar\""},
+      {"{\"e\":null}", "{\"a\":1}", "{\"e\":null,\"a\":1}"},
+      {"[1,2]", "{\"a\":\"b\",\"c\":null}", "{\"a\":\"b\"}"},
+      {"{}", "{\"a\":{\"bb\":{\"ccc\":null}}}", "{\"a\":{\"bb\":{}}}"},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    Json::Value expected = parse(cases[i][2]);
+    Json::Value target = parse(cases[i][0]);
+    Json::Value patch = parse(cases[i][1]);
+    target.mergePatch(patch);
+    JSONTEST_ASSERT_EQUAL(expected, target);
+    JSONTEST_ASSERT_EQUAL(parse(cases[i][1]), patch);
+
+    target = parse(cases[i][0]);
+    target.mergePatch(std::move(patch));
+    JSONTEST_ASSERT_EQUAL(expected, target);
+    JSONTEST_ASSERT_EQUAL(Json::nullValue, patch.type());
+  }
+  delete reader;
+
+  // Untouched branches keep sharing their payloads with copies of the base.
+  Json::Value base;
+  base["kept"]["list"].append("a string too long to be inlined");
+  base["changed"]["value"] = 1;
+  Json::Value copy = base;
+  Json::Value patch;
+  patch["changed"]["value"] = 2;
+  patch["changed"]["name"] = "a string too long to be inlined as well";
+  Json::Value shared = patch;
+  copy.mergePatch(std::move(patch));
+  JSONTEST_ASSERT_EQUAL(Json::Value(2), copy["changed"]["value"]);
+  JSONTEST_ASSERT_EQUAL(Json::Value(1), base["changed"]["value"]);
+  JSONTEST_ASSERT_EQUAL(base["kept"], copy["kept"]);
+  JSONTEST_ASSERT_EQUAL(2u, shared["changed"].size()); // copied, not taken
+}
+
+JSONTEST_FIXTURE(ValueTest, memoryUsage) {
+  Json::Value null;
+  JSONTEST_ASSERT_EQUAL(sizeof(Json::Value), null.memoryUsage().total());
+  JSONTEST_ASSERT_EQUAL(sizeof(Json::Value), null.memoryUsage().nodes);
+  JSONTEST_ASSERT_EQUAL(0u, Json::Value("abc").memoryUsage().strings);
+
+  const char text[] = "a string much too long to be held inside the Value";
+  Json::Value string(text);
+  Json::Value::MemoryUsage usage = string.memoryUsage();
+  JSONTEST_ASSERT(usage.strings > sizeof(text));
+  JSONTEST_ASSERT_EQUAL(usage.nodes + usage.strings, usage.total());
+  Json::Value staticString = Json::Value(Json::StaticString(text));
+  JSONTEST_ASSERT_EQUAL(0u, staticString.memoryUsage().strings);
+
+  // Strings and payloads shared by copies are counted once.
+  Json::Value list(Json::arrayValue);
+  list.reserve(2);
+  list.append(string);
+  size_t once = list.memoryUsage().strings;
+  list.append(string);
+  JSONTEST_ASSERT_EQUAL(once, list.memoryUsage().strings);
+  JSONTEST_ASSERT_EQUAL(usage.strings, once);
+  JSONTEST_ASSERT_EQUAL(3 * sizeof(Json::Value), list.memoryUsage().nodes);
+
+  // Names the object owns count as keys, static ones only as CZStrings.
+  Json::Value object;
+  object["name"] = 1;
+  Json::Value staticNames;
+  staticNames[Json::StaticString("name")] = 1;
+  JSONTEST_ASSERT_EQUAL(object.memoryUsage().keys,
+                        staticNames.memoryUsage().keys + 5);
+  JSONTEST_ASSERT(object.memoryUsage().containers > 0u);
+
+  object.setComment(JSONCPP_STRING("// a comment"), Json::commentBefore);
+  JSONTEST_ASSERT_EQUAL(sizeof("// a comment"), object.memoryUsage().comments);
+
+  // Approximate usage of similar records is close to the exact one.
+  Json::Value records(Json::arrayValue);
+  for (int i = 0; i < 1000; ++i) {
+    Json::Value& record = records.append(Json::objectValue);
+    record["id"] = i;
+    record["name"] = JSONCPP_STRING(40 + i % 10, 'x');
+  }
+  size_t exact = records.memoryUsage().total();
+  size_t approximate = records.memoryUsage(true).total();
+  JSONTEST_ASSERT(approximate > exact - exact / 20);
+  JSONTEST_ASSERT(approximate < exact + exact / 20);
+}
+
+JSONTEST_FIXTURE(ValueTest, hash) {
+  JSONTEST_ASSERT_EQUAL(Json::Value(0.0).hash(), Json::Value(-0.0).hash());
+  JSONTEST_ASSERT(Json::Value(1).hash() != Json::Value(1u).hash());
+  JSONTEST_ASSERT(Json::Value("").hash() != Json::Value().hash());
+
+  Json::Value object;
+  object["a"] = 1;
+  object["list"].append("x");
+  object["list"].append(2.5);
+  Json::Value same;
+  same["list"].append("x");
+  same["list"].append(2.5);
+  same["a"] = 1;
+  JSONTEST_ASSERT(object == same);
+  JSONTEST_ASSERT_EQUAL(object.hash(), same.hash());
+
+  // A shared copy hashes like the original; changing it changes the hash.
+  Json::Value copy(same);
+  size_t before = same.hash();
+  JSONTEST_ASSERT_EQUAL(before, copy.hash());
+  copy["list"][1] = 3.5;
+  JSONTEST_ASSERT(copy.hash() != before);
+  JSONTEST_ASSERT(copy != same);
+  JSONTEST_ASSERT_EQUAL(before, same.hash());
+
+  // A member held by reference is hashed as it is now.
+  Json::Value& list = object["list"];
+  size_t listHash = list.hash();
+  list.append(Json::Value());
+  JSONTEST_ASSERT(list.hash() != listHash);
+  JSONTEST_ASSERT(object != same);
+
+  // Removing a member of an object not shared changes its hash too.
+  Json::Value members;
+  members["a"] = 1;
+  members["b"] = 2;
+  Json::Value b;
+  b["b"] = 2;
+  size_t membersHash = members.hash();
+  members.removeMember("a");
+  JSONTEST_ASSERT(members == b);
+  JSONTEST_ASSERT_EQUAL(b.hash(), members.hash());
+  JSONTEST_ASSERT(members.hash() != membersHash);
+  members["a"] = 1;
+  members.hash();
+  members.removeMember(Json::Key("a"));
+  JSONTEST_ASSERT(members == b);
+  JSONTEST_ASSERT_EQUAL(b.hash(), members.hash());
+
+  std::unordered_set<Json::Value> set;
+  set.insert(same);
+  set.insert(copy);
+  set.insert(Json::Value(same));
+  JSONTEST_ASSERT_EQUAL(2u, set.size());
+  JSONTEST_ASSERT(set.count(copy) == 1);
+  JSONTEST_ASSERT(set.count(object) == 0);
+}
+
+JSONTEST_FIXTURE(ValueTest, reset) {
+  Json::Value array(Json::arrayValue);
+  array.reserve(10);
+  array.append(1);
+  array.append("two");
+  Json::Value copy(array);
+  array.reset();
+  JSONTEST_ASSERT(array.isArray());
+  JSONTEST_ASSERT_EQUAL(0u, array.size());
+  JSONTEST_ASSERT_EQUAL(2u, copy.size());
+
+  Json::Value object;
+  for (int i = 0; i < 100; ++i)
+    object[std::to_string(i)] = i;
+  object.setComment(JSONCPP_STRING("// kept"), Json::commentBefore);
+  object.reset();
+  JSONTEST_ASSERT(object.isObject());
+  JSONTEST_ASSERT_EQUAL(0u, object.size());
+  JSONTEST_ASSERT(object.hasComment(Json::commentBefore));
+  JSONTEST_ASSERT(object.find("7", "7" + 1) == NULL);
+  for (int i = 0; i < 3; ++i)
+    object[std::to_string(i)] = i;
+  JSONTEST_ASSERT_EQUAL(3u, object.size());
+  JSONTEST_ASSERT_EQUAL(2, object["2"].asInt());
+  JSONTEST_ASSERT(Json::Value::Members({"0", "1", "2"}) ==
+                  object.getMemberNames());
+
+  Json::Value string("a string too long to be inlined");
+  string.reset();
+  JSONTEST_ASSERT(string.isNull());
+}
+
+JSONTEST_FIXTURE(ValueTest, arena) {
+  Json::Arena arena(256);
+  Json::Value copy;
+  {
+    Json::Value root(arena, Json::objectValue);
+    JSONTEST_ASSERT(root.arena() == &arena);
+    root["name"] = "a string too long to be inlined";
+    Json::Value list;
+    for (int i = 0; i < 40; ++i)
+      list.append(std::to_string(i) + " is a number long enough");
+    Json::Value shared = list;
+    root["list"] = list; // copied into the arena
+    for (int i = 0; i < 20; ++i)
+      root["members"][std::to_string(i)] = i;
+    root["members"].setComment(JSONCPP_STRING("// kept"), Json::commentBefore);
+    JSONTEST_ASSERT(root["list"].arena() == &arena);
+    JSONTEST_ASSERT(root["list"][39].arena() == &arena);
+    JSONTEST_ASSERT(root["list"] == shared);
+    JSONTEST_ASSERT(list.arena() == NULL);
+    JSONTEST_ASSERT(arena.bytesUsed() > 40u * 24u);
+
+    // Copies made outside of the arena are deep.
+    copy = root;
+    JSONTEST_ASSERT(copy.arena() == NULL);
+    JSONTEST_ASSERT(copy == root);
+    root["list"].append(1);
+    root["members"].removeMember("3");
+    JSONTEST_ASSERT_EQUAL(40u, copy["list"].size());
+    JSONTEST_ASSERT_EQUAL(20u, copy["members"].size());
+    JSONTEST_ASSERT_EQUAL(19u, root["members"].size());
+  }
+  arena.release();
+  JSONTEST_ASSERT_EQUAL(0u, arena.bytesUsed());
+  JSONTEST_ASSERT_STRING_EQUAL("a string too long to be inlined",
+                               copy["name"].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("39 is a number long enough",
+                               copy["list"][39].asString());
+  JSONTEST_ASSERT_EQUAL(19, copy["members"]["19"].asInt());
+  JSONTEST_ASSERT(copy["members"].hasComment(Json::commentBefore));
+
+  Json::Arena other;
+  JSONTEST_ASSERT(other.id() != arena.id());
+  Json::Value root(arena);
+  root = copy;
+  JSONTEST_ASSERT(root == copy);
+  JSONTEST_ASSERT(root["members"].hasComment(Json::commentBefore));
+}
+
+JSONTEST_FIXTURE(ValueTest, deferredRelease) {
+  Json::DeferredRelease::flush();
+  Json::DeferredRelease::Stats before = Json::DeferredRelease::stats();
+
+  Json::Value object;
+  for (int i = 0; i < 100; ++i)
+    object[std::to_string(i)] = std::to_string(i) + " is a long string value";
+  Json::Value array;
+  for (int i = 0; i < 100; ++i)
+    array.append(object["7"]);
+  Json::deferredRelease(std::move(object));
+  Json::deferredRelease(std::move(array));
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, object.type());
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, array.type());
+  Json::DeferredRelease::flush();
+  Json::DeferredRelease::Stats after = Json::DeferredRelease::stats();
+  JSONTEST_ASSERT_EQUAL(0u, after.queueDepth);
+  JSONTEST_ASSERT_EQUAL(before.released + 2, after.released);
+  JSONTEST_ASSERT(after.reclaimedBytes > before.reclaimedBytes);
+
+  // Shared and scalar values are destroyed on the spot.
+  Json::Value source(Json::arrayValue);
+  source.append(1);
+  Json::Value list = source; // a fresh payload, which copies share
+  Json::Value copy = list;
+  Json::deferredRelease(std::move(list));
+  Json::deferredRelease(Json::Value("a string"));
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, list.type());
+  JSONTEST_ASSERT_EQUAL(1u, copy.size());
+  Json::DeferredRelease::flush();
+  JSONTEST_ASSERT_EQUAL(after.released, Json::DeferredRelease::stats().released);
+
+  // So is everything while the queue is full.
+  size_t limit = Json::DeferredRelease::queueLimit();
+  Json::DeferredRelease::setQueueLimit(0);
+  Json::deferredRelease(std::move(copy));
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, copy.type());
+  JSONTEST_ASSERT_EQUAL(after.releasedInPlace + 1,
+                        Json::DeferredRelease::stats().releasedInPlace);
+  Json::DeferredRelease::setQueueLimit(limit);
+}
+
 JSONTEST_FIXTURE(ValueTest, StaticString) {
   char mutant[] = "hello";
   Json::StaticString ss(mutant);
@@ -2426,6 +3206,7 @@ JSONTEST_FIXTURE(CharReaderTest, parseWithNoErrors) {
 
 JSONTEST_FIXTURE(CharReaderTest, parseWithNoErrorsTestingOffsets) {
   Json::CharReaderBuilder b;
+  b.settings_["collectOffsets"] = true;
   Json::CharReader* reader(b.newCharReader());
   JSONCPP_STRING errs;
   Json::Value root;
@@ -2438,9 +3219,529 @@ JSONTEST_FIXTURE(CharReaderTest, parseWithNoErrorsTestingOffsets) {
       &root, &errs);
   JSONTEST_ASSERT(ok);
   JSONTEST_ASSERT(errs.size() == 0);
+  JSONTEST_ASSERT_EQUAL(0, root.getOffsetStart());
+  JSONTEST_ASSERT_EQUAL(static_cast<ptrdiff_t>(std::strlen(doc)), root.getOffsetLimit());
+  JSONTEST_ASSERT_EQUAL(15, root["property"].getOffsetStart());
+  JSONTEST_ASSERT_EQUAL(34, root["property"].getOffsetLimit());
+  JSONTEST_ASSERT_EQUAL(16, root["property"][0].getOffsetStart());
+  JSONTEST_ASSERT_EQUAL(23, root["property"][0].getOffsetLimit());
   delete reader;
 }
 
+JSONTEST_FIXTURE(CharReaderTest, parseWithoutOffsets) {
+  Json::CharReaderBuilder b;
+  JSONTEST_ASSERT_EQUAL(false, b.settings_["collectOffsets"].asBool());
+  Json::CharReader* reader(b.newCharReader());
+  JSONCPP_STRING errs;
+  Json::Value root;
+  char const doc[] = "{ \"property\" : [\"value\", \"value2\"] }";
+  bool ok = reader->parse(
+      doc, doc + std::strlen(doc),
+      &root, &errs);
+  JSONTEST_ASSERT(ok);
+  JSONTEST_ASSERT(errs.size() == 0);
+  JSONTEST_ASSERT_EQUAL(0, root.getOffsetLimit());
+  JSONTEST_ASSERT_EQUAL(0, root["property"].getOffsetStart());
+  JSONTEST_ASSERT_EQUAL(0, root["property"][1].getOffsetLimit());
+  JSONTEST_ASSERT_STRING_EQUAL("value2", root["property"][1].asString());
+  delete reader;
+}
+
+JSONTEST_FIXTURE(CharReaderTest, parseWithInternedKeys) {
+  char const name[] = "property";
+  char const* pooled = Json::KeyPool::intern(name, name + 8);
+  JSONTEST_ASSERT(pooled != NULL);
+  JSONTEST_ASSERT(pooled != name);
+  JSONTEST_ASSERT_STRING_EQUAL("property", pooled);
+  JSONTEST_ASSERT(pooled == Json::KeyPool::intern(name, name + 8));
+  char const withZero[] = "a\0b";
+  JSONTEST_ASSERT(Json::KeyPool::intern(withZero, withZero + 3) == NULL);
+  JSONCPP_STRING longName(Json::KeyPool::maxNameLength + 1, 'n');
+  JSONTEST_ASSERT(Json::KeyPool::intern(longName.data(),
+                                        longName.data() + longName.size()) ==
+                  NULL);
+
+  Json::CharReaderBuilder b;
+  b.settings_["internKeys"] = true;
+  JSONTEST_ASSERT(b.validate(NULL));
+  Json::CharReader* reader(b.newCharReader());
+  JSONCPP_STRING errs;
+  Json::Value root;
+  char const doc[] = "[{ \"property\" : 1 }, { \"property\" : 2 }]";
+  bool ok = reader->parse(
+      doc, doc + std::strlen(doc),
+      &root, &errs);
+  JSONTEST_ASSERT(ok);
+  JSONTEST_ASSERT(errs.size() == 0);
+  char const* end = 0;
+  char const* first = root[0].begin().memberName(&end);
+  JSONTEST_ASSERT_EQUAL(8, end - first);
+  JSONTEST_ASSERT(first == pooled);
+  JSONTEST_ASSERT(root[1].begin().memberName(&end) == pooled);
+  JSONTEST_ASSERT_EQUAL(2, root[1]["property"].asInt());
+
+  // Names the pool does not take are copied.
+  JSONCPP_STRING longDoc = "{ \"" + longName + "\" : 1 }";
+  JSONTEST_ASSERT(reader->parse(longDoc.data(),
+                                longDoc.data() + longDoc.size(), &root, &errs));
+  JSONTEST_ASSERT_STRING_EQUAL(longName, root.getMemberNames()[0]);
+  delete reader;
+
+  Json::Value object;
+  object["property"] = 1;
+  JSONTEST_ASSERT(object.begin().memberName(&end) != pooled);
+  JSONTEST_ASSERT(!Json::KeyPool::isEnabled());
+  Json::KeyPool::setEnabled(true);
+  Json::Value pooledObject;
+  pooledObject["property"] = 1;
+  Json::KeyPool::setEnabled(false);
+  JSONTEST_ASSERT(pooledObject.begin().memberName(&end) == pooled);
+  JSONTEST_ASSERT(object == pooledObject);
+}
+
+JSONTEST_FIXTURE(CharReaderTest, parseWithSizeHints) {
+  Json::CharReaderBuilder b;
+  b.settings_["sizeHints"] = true;
+  JSONTEST_ASSERT(b.validate(NULL));
+  Json::CharReader* reader(b.newCharReader());
+  JSONCPP_STRING errs;
+  Json::Value root;
+  char const doc[] =
+      "[ { \"a\" : [1, 2, 3], \"b\" : 1 }, { \"a\" : [], \"b\" : 2 },"
+      "  { \"a\" : [4, 5, 6, 7], \"b\" : 3, \"c\" : 4 } ]";
+  for (int pass = 0; pass < 2; ++pass) {
+    bool ok = reader->parse(
+        doc, doc + std::strlen(doc),
+        &root, &errs);
+    JSONTEST_ASSERT(ok);
+    JSONTEST_ASSERT(errs.size() == 0);
+    JSONTEST_ASSERT_EQUAL(3u, root.size());
+    JSONTEST_ASSERT_EQUAL(0u, root[1]["a"].size());
+    JSONTEST_ASSERT_EQUAL(4u, root[2]["a"].size());
+    JSONTEST_ASSERT_EQUAL(3u, root[2].size());
+    JSONTEST_ASSERT_EQUAL(4, root[2]["c"].asInt());
+  }
+  delete reader;
+}
+
+JSONTEST_FIXTURE(CharReaderTest, parseWithLazyNumbers) {
+  Json::CharReaderBuilder b;
+  b.settings_["lazyNumbers"] = true;
+  JSONTEST_ASSERT(b.validate(NULL));
+  Json::CharReader* reader(b.newCharReader());
+  JSONCPP_STRING errs;
+  Json::Value root;
+  char const doc[] =
+      "[0.1, -2.50, 7, 123456789012345678901234, 1E2, -.5]";
+  bool ok = reader->parse(
+      doc, doc + std::strlen(doc),
+      &root, &errs);
+  JSONTEST_ASSERT(ok);
+  JSONTEST_ASSERT(errs.size() == 0);
+  char const* begin;
+  char const* end;
+  JSONTEST_ASSERT(root[0].getNumberText(&begin, &end));
+  JSONTEST_ASSERT_STRING_EQUAL("0.1", JSONCPP_STRING(begin, end));
+  JSONTEST_ASSERT_EQUAL(Json::realValue, root[0].type());
+  JSONTEST_ASSERT_EQUAL(0.1, root[0].asDouble());
+  JSONTEST_ASSERT(root[0] == Json::Value(0.1));
+  JSONTEST_ASSERT_EQUAL(Json::Value(0.1).hash(), root[0].hash());
+  JSONTEST_ASSERT_EQUAL(-2, root[1].asInt());
+  // Integers are decoded as they are read.
+  JSONTEST_ASSERT_EQUAL(Json::intValue, root[2].type());
+  JSONTEST_ASSERT(!root[2].getNumberText(&begin, &end));
+  JSONTEST_ASSERT(root[4].isUInt());
+  JSONTEST_ASSERT_EQUAL(100u, root[4].asUInt());
+
+  // Copies share the text; writers output it as it was read.
+  Json::Value copy(root);
+  Json::StreamWriterBuilder w;
+  w.settings_["indentation"] = "";
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[0.1,-2.50,7,123456789012345678901234,1E2,-.5]",
+      Json::writeString(w, copy));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[0.1,-2.50,7,123456789012345678901234,1E2,-.5]\n",
+      Json::FastWriter().write(copy));
+
+  copy[0] = 0.25;
+  JSONTEST_ASSERT(!copy[0].getNumberText(&begin, &end));
+  JSONTEST_ASSERT_EQUAL(0.25, copy[0].asDouble());
+  JSONTEST_ASSERT_EQUAL(0.1, root[0].asDouble());
+  delete reader;
+}
+
+JSONTEST_FIXTURE(CharReaderTest, parseWithLazyStrings) {
+  Json::CharReaderBuilder b;
+  b.settings_["lazyStrings"] = true;
+  JSONTEST_ASSERT(b.validate(NULL));
+  Json::CharReader* reader(b.newCharReader());
+  JSONCPP_STRING errs;
+  Json::Value root;
+  char const doc[] =
+      "[\"plain\", \"tab\\there\", \"\\u00e9\\ud83d\\ude00\", \"\", \"a\\/b\"]";
+  bool ok = reader->parse(
+      doc, doc + std::strlen(doc),
+      &root, &errs);
+  JSONTEST_ASSERT(ok);
+  JSONTEST_ASSERT(errs.size() == 0);
+  char const* begin;
+  char const* end;
+  JSONTEST_ASSERT(root[1].getRawString(&begin, &end));
+  JSONTEST_ASSERT_STRING_EQUAL("tab\\there", JSONCPP_STRING(begin, end));
+  JSONTEST_ASSERT_STRING_EQUAL("tab\there", root[1].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("plain", root[0].asCString());
+  JSONTEST_ASSERT_STRING_EQUAL("a/b", root[4].asString());
+  Json::Value unescaped("\xc3\xa9\xf0\x9f\x98\x80");
+  JSONTEST_ASSERT(root[2] == unescaped);
+  JSONTEST_ASSERT_EQUAL(unescaped.hash(), root[2].hash());
+  JSONTEST_ASSERT(root[3] == Json::Value(""));
+
+  // Copies share the text; writers output it as it was read, when it is
+  // what they would write for the string.
+  Json::Value copy(root);
+  JSONTEST_ASSERT_STRING_EQUAL("\xc3\xa9\xf0\x9f\x98\x80", copy[2].asString());
+  JSONTEST_ASSERT(!copy[2].getRawString(&begin, &end));
+  JSONTEST_ASSERT(!copy[4].getRawString(&begin, &end));
+  Json::StreamWriterBuilder w;
+  w.settings_["indentation"] = "";
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[\"plain\",\"tab\\there\",\"\xc3\xa9\xf0\x9f\x98\x80\",\"\",\"a/b\"]",
+      Json::writeString(w, copy));
+
+  // Any writer outputs what it does for the strings read eagerly.
+  char const raw[] = "[\"a\tb\", \"caf\xc3\xa9\", \"x\\u00e9y\", \"\\u001F\\u001f\"]";
+  Json::Value lazy;
+  ok = reader->parse(raw, raw + std::strlen(raw), &lazy, &errs);
+  JSONTEST_ASSERT(ok);
+  Json::Value eager;
+  Json::CharReader* eagerReader(Json::CharReaderBuilder().newCharReader());
+  ok = eagerReader->parse(raw, raw + std::strlen(raw), &eager, &errs);
+  JSONTEST_ASSERT(ok);
+  delete eagerReader;
+  JSONTEST_ASSERT(lazy == eager);
+  JSONTEST_ASSERT(lazy[1].getRawString(&begin, &end));
+  JSONTEST_ASSERT(!lazy[0].getRawString(&begin, &end));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "[\"a\\tb\",\"caf\xc3\xa9\",\"x\xc3\xa9y\",\"\\u001F\\u001F\"]",
+      Json::writeString(w, lazy));
+  JSONTEST_ASSERT_STRING_EQUAL(Json::writeString(w, eager),
+                               Json::writeString(w, lazy));
+  JSONTEST_ASSERT_STRING_EQUAL(Json::FastWriter().write(eager),
+                               Json::FastWriter().write(lazy));
+  JSONTEST_ASSERT_STRING_EQUAL(Json::StyledWriter().write(eager),
+                               Json::StyledWriter().write(lazy));
+  JSONCPP_OSTRINGSTREAM eagerStream;
+  JSONCPP_OSTRINGSTREAM lazyStream;
+  Json::StyledStreamWriter().write(eagerStream, eager);
+  Json::StyledStreamWriter().write(lazyStream, lazy);
+  JSONTEST_ASSERT_STRING_EQUAL(eagerStream.str(), lazyStream.str());
+
+  copy[4] = "a/b";
+  JSONTEST_ASSERT(!copy[4].getRawString(&begin, &end));
+  JSONTEST_ASSERT(copy[4] == root[4]);
+
+  // Bad escape sequences are still reported while parsing.
+  char const bad[] = "[\"a\\x\"]";
+  ok = reader->parse(bad, bad + std::strlen(bad), &root, &errs);
+  JSONTEST_ASSERT(!ok);
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "* Line 1, Column 2\n  Bad escape sequence in string\n"
+      "See Line 1, Column 6 for detail.\n",
+      errs);
+  delete reader;
+}
+
+JSONTEST_FIXTURE(CharReaderTest, parseWithReuse) {
+  Json::CharReaderBuilder b;
+  b.settings_["reuseValues"] = true;
+  b.settings_["rejectDupKeys"] = true;
+  JSONTEST_ASSERT(b.validate(NULL));
+  Json::CharReader* reader(b.newCharReader());
+  Json::CharReader* plainReader(Json::CharReaderBuilder().newCharReader());
+  JSONCPP_STRING errs;
+  Json::Value root;
+  char const first[] =
+      "{ \"list\" : [ { \"id\" : 1, \"name\" : \"the first record\" }, 2, 3 ],"
+      "  \"gone\" : 1, \"kind\" : [] }";
+  char const second[] =
+      "{ \"kind\" : {}, \"list\" : [ { \"name\" : \"the second\", \"id\" : 2 } ],"
+      "  \"new\" : true }";
+  JSONTEST_ASSERT(reader->parse(first, first + std::strlen(first), &root, &errs));
+  Json::Value snapshot = root;
+  JSONTEST_ASSERT(reader->parse(second, second + std::strlen(second), &root, &errs));
+  Json::Value expected;
+  JSONTEST_ASSERT(plainReader->parse(second, second + std::strlen(second), &expected, &errs));
+  JSONTEST_ASSERT(root == expected);
+  JSONTEST_ASSERT_EQUAL(3u, snapshot["list"].size());
+  JSONTEST_ASSERT_STRING_EQUAL("the first record",
+                               snapshot["list"][0]["name"].asString());
+
+  // Once the document is no longer shared, it is read over in place.
+  snapshot = Json::Value();
+  JSONTEST_ASSERT(reader->parse(first, first + std::strlen(first), &root, &errs));
+  Json::Value* record = &root["list"][0];
+  char const* name = record->get("name", "").asCString();
+  JSONTEST_ASSERT(reader->parse(second, second + std::strlen(second), &root, &errs));
+  JSONTEST_ASSERT(root == expected);
+  JSONTEST_ASSERT(&root["list"][0] == record);
+  JSONTEST_ASSERT(root["list"][0].get("name", "").asCString() == name);
+  // A shorter string does not shrink the room for the next one.
+  JSONTEST_ASSERT(reader->parse(first, first + std::strlen(first), &root, &errs));
+  JSONTEST_ASSERT(root["list"][0].get("name", "").asCString() == name);
+  JSONTEST_ASSERT_STRING_EQUAL("the first record",
+                               root["list"][0]["name"].asString());
+  JSONTEST_ASSERT(reader->parse(second, second + std::strlen(second), &root, &errs));
+
+  // Duplicates are still told from the members of the previous document.
+  char const duplicate[] = "{ \"new\" : 1, \"new\" : 2 }";
+  JSONTEST_ASSERT(!reader->parse(duplicate, duplicate + std::strlen(duplicate),
+                                 &root, &errs));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "* Line 1, Column 14\n  Duplicate key: 'new'\n", errs);
+  delete plainReader;
+  delete reader;
+}
+
+JSONTEST_FIXTURE(CharReaderTest, parseIntoArena) {
+  Json::CharReaderBuilder b;
+  b.settings_["collectOffsets"] = true;
+  Json::CharReader* reader(b.newCharReader());
+  b.settings_["lazyNumbers"] = true;
+  b.settings_["lazyStrings"] = true;
+  b.settings_["reuseValues"] = true;
+  Json::CharReader* lazyReader(b.newCharReader());
+  JSONCPP_STRING errs;
+  char const doc[] =
+      "// the records\n"
+      "{ \"records\" : [ { \"id\" : 1, \"name\" : \"the first record\" },"
+      "  { \"id\" : 2.5, \"name\" : \"an \\\"escaped\\\" name\" } ],"
+      "  \"total\" : 2 }";
+  Json::Value expected;
+  JSONTEST_ASSERT(reader->parse(doc, doc + std::strlen(doc), &expected, &errs));
+  Json::Arena arena;
+  for (int pass = 0; pass < 2; ++pass) {
+    {
+      Json::Value root(arena);
+      JSONTEST_ASSERT(reader->parse(doc, doc + std::strlen(doc), &root, &errs));
+      JSONTEST_ASSERT(root == expected);
+      JSONTEST_ASSERT(root.hasComment(Json::commentBefore));
+      JSONTEST_ASSERT_EQUAL(expected["records"][1].getOffsetStart(),
+                            root["records"][1].getOffsetStart());
+      JSONTEST_ASSERT(root["records"][1]["name"].arena() == &arena);
+      // Read again over itself.
+      JSONTEST_ASSERT(
+          lazyReader->parse(doc, doc + std::strlen(doc), &root, &errs));
+      JSONTEST_ASSERT(root == expected);
+      JSONTEST_ASSERT_STRING_EQUAL("an \"escaped\" name",
+                                   root["records"][1]["name"].asString());
+      JSONTEST_ASSERT_EQUAL(2.5, root["records"][1]["id"].asDouble());
+    }
+    JSONTEST_ASSERT(arena.bytesUsed() > 0u);
+    arena.release();
+  }
+  delete lazyReader;
+  delete reader;
+}
+
+JSONTEST_FIXTURE(CharReaderTest, parseWithPackedNumbers) {
+  Json::CharReaderBuilder b;
+  Json::CharReader* plainReader(b.newCharReader());
+  b.settings_["packNumbers"] = true;
+  b.settings_["collectOffsets"] = false;
+  JSONTEST_ASSERT(b.validate(NULL));
+  Json::CharReader* reader(b.newCharReader());
+  JSONCPP_STRING errs;
+  JSONCPP_OSTRINGSTREAM doc;
+  doc << "{ \"reals\" : [";
+  for (int i = 0; i < 20; ++i)
+    doc << (i ? ", " : " ") << i << ".5";
+  doc << " ], \"ints\" : [";
+  for (int i = 0; i < 20; ++i)
+    doc << (i ? ", " : " ") << -i;
+  doc << " ], \"mixed\" : [";
+  for (int i = 0; i < 20; ++i)
+    doc << (i ? ", " : " ") << i << (i % 2 ? ".5" : "");
+  doc << " ], \"short\" : [ 1, 2, 3 ] }";
+  const JSONCPP_STRING text = doc.str();
+  Json::Value root;
+  Json::Value expected;
+  JSONTEST_ASSERT(reader->parse(text.data(), text.data() + text.size(), &root,
+                                &errs));
+  JSONTEST_ASSERT(plainReader->parse(text.data(), text.data() + text.size(),
+                                     &expected, &errs));
+
+  double const* reals;
+  double const* realsEnd;
+  Json::LargestInt const* ints;
+  Json::LargestInt const* intsEnd;
+  const Json::Value& constRoot = root;
+  JSONTEST_ASSERT(constRoot["reals"].getPackedReals(&reals, &realsEnd));
+  JSONTEST_ASSERT_EQUAL(20, realsEnd - reals);
+  JSONTEST_ASSERT_EQUAL(19.5, reals[19]);
+  JSONTEST_ASSERT(!constRoot["reals"].getPackedInts(&ints, &intsEnd));
+  JSONTEST_ASSERT(constRoot["ints"].getPackedInts(&ints, &intsEnd));
+  JSONTEST_ASSERT_EQUAL(-7, ints[7]);
+  JSONTEST_ASSERT(!constRoot["mixed"].getPackedReals(&reals, &realsEnd));
+  JSONTEST_ASSERT(!constRoot["short"].getPackedInts(&ints, &intsEnd));
+  JSONTEST_ASSERT(!expected["ints"].getPackedInts(&ints, &intsEnd));
+
+  // Packed arrays read, compare and hash as the others do.
+  JSONTEST_ASSERT_EQUAL(20u, constRoot["ints"].size());
+  JSONTEST_ASSERT(constRoot == expected);
+  JSONTEST_ASSERT_EQUAL(expected.hash(), constRoot.hash());
+  JSONTEST_ASSERT_EQUAL(Json::intValue, constRoot["ints"][3].type());
+  JSONTEST_ASSERT_EQUAL(-3, constRoot["ints"][3].asInt());
+  JSONTEST_ASSERT_EQUAL(2.5, constRoot["reals"][2].asDouble());
+  double sum = 0;
+  for (Json::Value::const_iterator it = constRoot["reals"].begin();
+       it != constRoot["reals"].end(); ++it)
+    sum += it->asDouble();
+  JSONTEST_ASSERT_EQUAL(200.0, sum);
+
+  // Copies stay packed; modifying an array boxes its numbers for good.
+  Json::Value copy = constRoot["ints"];
+  JSONTEST_ASSERT(copy.getPackedInts(&ints, &intsEnd));
+  copy.append(1);
+  JSONTEST_ASSERT(!copy.getPackedInts(&ints, &intsEnd));
+  JSONTEST_ASSERT_EQUAL(21u, copy.size());
+  JSONTEST_ASSERT_EQUAL(-19, copy[19].asInt());
+  JSONTEST_ASSERT(constRoot["ints"].getPackedInts(&ints, &intsEnd));
+  root["ints"].clear();
+  JSONTEST_ASSERT(root["ints"].empty());
+
+  // Numbers with comments keep their Values.
+  char const commented[] =
+      "[ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 // last\n]";
+  JSONTEST_ASSERT(reader->parse(commented, commented + std::strlen(commented),
+                                &root, &errs));
+  JSONTEST_ASSERT(!root.getPackedInts(&ints, &intsEnd));
+  JSONTEST_ASSERT(root[15].hasComment(Json::commentAfterOnSameLine));
+
+  // Writers output packed numbers without boxing them.
+  JSONTEST_ASSERT(reader->parse(text.data(), text.data() + text.size(), &root,
+                                &errs));
+  Json::Value::MemoryUsage usage = root.memoryUsage();
+  JSONTEST_ASSERT_STRING_EQUAL(Json::FastWriter().write(expected),
+                               Json::FastWriter().write(root));
+  JSONTEST_ASSERT_STRING_EQUAL(Json::StyledWriter().write(expected),
+                               Json::StyledWriter().write(root));
+  Json::StreamWriterBuilder w;
+  JSONTEST_ASSERT_STRING_EQUAL(Json::writeString(w, expected),
+                               Json::writeString(w, root));
+  JSONTEST_ASSERT_EQUAL(usage.total(), root.memoryUsage().total());
+
+  // Numbers with source offsets keep their Values, and the offsets.
+  b.settings_["collectOffsets"] = true;
+  Json::CharReader* offsetReader(b.newCharReader());
+  JSONTEST_ASSERT(offsetReader->parse(text.data(), text.data() + text.size(),
+                                      &root, &errs));
+  JSONTEST_ASSERT(!root["ints"].getPackedInts(&ints, &intsEnd));
+  JSONTEST_ASSERT_EQUAL(static_cast<ptrdiff_t>(text.find("-3")),
+                        root["ints"][3].getOffsetStart());
+  delete offsetReader;
+  delete reader;
+  delete plainReader;
+}
+
+JSONTEST_FIXTURE(CharReaderTest, parseWithSharedShapes) {
+  Json::CharReaderBuilder b;
+  Json::CharReader* plainReader(b.newCharReader());
+  b.settings_["shareShapes"] = true;
+  JSONTEST_ASSERT(b.validate(NULL));
+  Json::CharReader* reader(b.newCharReader());
+  JSONCPP_STRING errs;
+  JSONCPP_OSTRINGSTREAM doc;
+  doc << "[";
+  for (int i = 0; i < 4; ++i)
+    doc << "{ \"id\" : " << i << ", \"name\" : \"n" << i
+        << "\", \"tags\" : { \"a\" : 1 } }, ";
+  doc << "{ \"id\" : 4, \"other\" : true }, {";
+  for (int i = 0; i < 20; ++i)
+    doc << (i ? ", " : " ") << "\"m" << 10 + i << "\" : " << i;
+  doc << " } ]";
+  const JSONCPP_STRING text = doc.str();
+  Json::Value root;
+  Json::Value expected;
+  JSONTEST_ASSERT(reader->parse(text.data(), text.data() + text.size(), &root,
+                                &errs));
+  JSONTEST_ASSERT(plainReader->parse(text.data(), text.data() + text.size(),
+                                     &expected, &errs));
+  JSONTEST_ASSERT(root == expected);
+  JSONTEST_ASSERT_EQUAL(expected.hash(), root.hash());
+  JSONTEST_ASSERT(!(root < expected) && !(expected < root));
+
+  // Records with the same members share their names, from the second on.
+  const Json::Value& records = root;
+  char const* end;
+  JSONTEST_ASSERT(records[1].begin().memberName(&end) ==
+                  records[3].begin().memberName(&end));
+  JSONTEST_ASSERT(records[1]["tags"].begin().memberName(&end) ==
+                  records[2]["tags"].begin().memberName(&end));
+  JSONTEST_ASSERT(records[0].begin().memberName(&end) !=
+                  records[1].begin().memberName(&end));
+  JSONTEST_ASSERT(records[1].begin().memberName(&end) !=
+                  records[4].begin().memberName(&end));
+  JSONTEST_ASSERT_EQUAL(3u, records[1].size());
+  JSONTEST_ASSERT_STRING_EQUAL("n2", records[2]["name"].asString());
+  JSONTEST_ASSERT(records[2].isMember("tags"));
+  JSONTEST_ASSERT(!records[2].isMember("other"));
+  JSONTEST_ASSERT_EQUAL(19, records[5]["m29"].asInt());
+  Json::Value::Members names = records[1].getMemberNames();
+  JSONTEST_ASSERT_EQUAL(3u, names.size());
+  JSONTEST_ASSERT_STRING_EQUAL("id", names[0]);
+  JSONTEST_ASSERT_STRING_EQUAL("tags", names[2]);
+
+  // Values change in place; names only for the object changed.
+  root[2]["name"] = "renamed";
+  JSONTEST_ASSERT(records[2].begin().memberName(&end) ==
+                  records[1].begin().memberName(&end));
+  root[1]["added"] = true;
+  Json::Value removed;
+  JSONTEST_ASSERT(root[2].removeMember("id", &removed));
+  JSONTEST_ASSERT_EQUAL(2, removed.asInt());
+  JSONTEST_ASSERT_EQUAL(4u, records[1].size());
+  JSONTEST_ASSERT_EQUAL(2u, records[2].size());
+  JSONTEST_ASSERT_EQUAL(3u, records[3].size());
+  JSONTEST_ASSERT(records[1]["added"].asBool());
+  JSONTEST_ASSERT_STRING_EQUAL("n1", records[1]["name"].asString());
+  JSONTEST_ASSERT_STRING_EQUAL("renamed", records[2]["name"].asString());
+  Json::Value copy = records[3];
+  copy["id"] = 30;
+  JSONTEST_ASSERT_EQUAL(3, records[3]["id"].asInt());
+  root[5]["m00"] = 0;
+  JSONTEST_ASSERT_EQUAL(21u, records[5].size());
+  JSONTEST_ASSERT_EQUAL(19, records[5]["m29"].asInt());
+
+  // Shapes are kept from one document to the next.
+  char const next[] = "[ { \"id\" : 7, \"name\" : \"x\", \"tags\" : {} } ]";
+  Json::Value first;
+  Json::Value second;
+  JSONTEST_ASSERT(reader->parse(next, next + std::strlen(next), &first, &errs));
+  JSONTEST_ASSERT(
+      reader->parse(next, next + std::strlen(next), &second, &errs));
+  const Json::Value& firstRecords = first;
+  const Json::Value& secondRecords = second;
+  JSONTEST_ASSERT(firstRecords[0].begin().memberName(&end) ==
+                  secondRecords[0].begin().memberName(&end));
+
+  // Objects alternating at the same depth are left as they are.
+  char const alternating[] =
+      "[ { \"a\" : { \"x\" : 1 }, \"b\" : { \"y\" : 2 } },"
+      "  { \"a\" : { \"x\" : 3 }, \"b\" : { \"y\" : 4 } } ]";
+  JSONTEST_ASSERT(reader->parse(
+      alternating, alternating + std::strlen(alternating), &root, &errs));
+  JSONTEST_ASSERT(plainReader->parse(
+      alternating, alternating + std::strlen(alternating), &expected, &errs));
+  JSONTEST_ASSERT(root == expected);
+  JSONTEST_ASSERT_EQUAL(expected[1]["a"].memoryUsage().total(),
+                        root[1]["a"].memoryUsage().total());
+  JSONTEST_ASSERT_EQUAL(expected[1]["b"].memoryUsage().total(),
+                        root[1]["b"].memoryUsage().total());
+  delete reader;
+  delete plainReader;
+}
+
 JSONTEST_FIXTURE(CharReaderTest, parseWithOneError) {
   Json::CharReaderBuilder b;
   Json::CharReader* reader(b.newCharReader());
@@ -2520,6 +3821,30 @@ JSONTEST_FIXTURE(CharReaderTest, parseWithStackLimit) {
   }
 }
 
+JSONTEST_FIXTURE(CharReaderTest, parseCommentsOnReorderedMembers) {
+  // Each member is inserted before the previous one, which then moves.
+  Json::CharReaderBuilder b;
+  Json::CharReader* reader(b.newCharReader());
+  JSONCPP_STRING errs;
+  Json::Value root;
+  char const doc[] = "{ \"c\" : 3, // after c\n"
+                     "  \"b\" : [ 2 ], // after b\n"
+                     "  \"a\" : 1 // after a\n"
+                     "}";
+  bool ok = reader->parse(
+      doc, doc + std::strlen(doc),
+      &root, &errs);
+  JSONTEST_ASSERT(ok);
+  JSONTEST_ASSERT(errs == "");
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "// after c", root["c"].getComment(Json::commentAfterOnSameLine));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "// after b", root["b"].getComment(Json::commentAfterOnSameLine));
+  JSONTEST_ASSERT_STRING_EQUAL(
+      "// after a", root["a"].getComment(Json::commentAfterOnSameLine));
+  delete reader;
+}
+
 struct CharReaderStrictModeTest : JsonTest::TestCase {};
 
 JSONTEST_FIXTURE(CharReaderStrictModeTest, dupKeys) {
@@ -3071,15 +4396,270 @@ JSONTEST_FIXTURE(RValueTest, moveConstruction) {
 #endif
 }
 
+struct FrozenValueTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE(FrozenValueTest, fromValue) {
+  Json::Value value;
+  value["null"] = Json::Value();
+  value["bool"] = true;
+  value["int"] = -42;
+  value["uint"] = Json::Value::maxLargestUInt;
+  value["real"] = 2.5;
+  value["string"] = "a string too long to be inlined";
+  value[std::string("embedded\0null", 13)] = "";
+  for (int i = 0; i < 30; ++i) {
+    Json::Value& item = value["list"].append(Json::objectValue);
+    item["id"] = i;
+    item["name"] = "item " + std::to_string(i);
+  }
+
+  Json::FrozenValue frozen(value);
+  JSONTEST_ASSERT_EQUAL(Json::objectValue, frozen.type());
+  JSONTEST_ASSERT_EQUAL(value.size(), frozen.size());
+  JSONTEST_ASSERT(frozen["null"].isNull());
+  JSONTEST_ASSERT(frozen["missing"].isNull());
+  JSONTEST_ASSERT(!frozen.isMember("missing"));
+  JSONTEST_ASSERT(frozen["bool"].asBool());
+  JSONTEST_ASSERT(frozen["int"].isInt());
+  JSONTEST_ASSERT_EQUAL(-42, frozen["int"].asInt());
+  JSONTEST_ASSERT_EQUAL("-42", frozen["int"].asString());
+  JSONTEST_ASSERT(!frozen["uint"].isInt64());
+  JSONTEST_ASSERT_EQUAL(Json::Value::maxLargestUInt,
+                        frozen["uint"].asLargestUInt());
+  JSONTEST_ASSERT_EQUAL(2.5, frozen["real"].asDouble());
+  JSONTEST_ASSERT(!frozen["real"].isIntegral());
+  JSONTEST_ASSERT_STRING_EQUAL("a string too long to be inlined",
+                               frozen["string"].asCString());
+  const char* name = "embedded\0null";
+  Json::FrozenNode member;
+  JSONTEST_ASSERT(frozen.find(name, name + 13, &member));
+  JSONTEST_ASSERT(member.isString() && member.empty() == false);
+  JSONTEST_ASSERT(!frozen.find(name, name + 8, &member));
+
+  Json::FrozenNode list = frozen["list"];
+  JSONTEST_ASSERT_EQUAL(30u, list.size());
+  JSONTEST_ASSERT_EQUAL(17, list[17]["id"].asInt());
+  JSONTEST_ASSERT_EQUAL("item 29", list[29u]["name"].asString());
+  JSONTEST_ASSERT(list[30].isNull());
+  Json::ArrayIndex expected = 0;
+  for (Json::FrozenNode::const_iterator it = list.begin(); it != list.end();
+       ++it, ++expected) {
+    JSONTEST_ASSERT_EQUAL(expected, it.index());
+    JSONTEST_ASSERT_EQUAL(Json::Int(expected), (*it)["id"].asInt());
+  }
+  JSONTEST_ASSERT_EQUAL(30u, expected);
+
+  // Members come in the order of Value, names included.
+  Json::Value::const_iterator member_it = value.begin();
+  for (Json::FrozenNode::const_iterator it = frozen.begin();
+       it != frozen.end(); ++it, ++member_it)
+    JSONTEST_ASSERT_EQUAL(member_it.name(), it.name());
+  JSONTEST_ASSERT(member_it == value.end());
+
+  JSONTEST_ASSERT_EQUAL(value, frozen.toValue());
+  JSONTEST_ASSERT(frozen["list"].toValue() == value["list"]);
+
+  // Copies own their tape; nodes follow theirs through a move.
+  Json::FrozenValue copy(frozen);
+  Json::FrozenValue moved(std::move(frozen));
+  JSONTEST_ASSERT(frozen.isNull());
+  JSONTEST_ASSERT_EQUAL(17, list[17]["id"].asInt());
+  JSONTEST_ASSERT_EQUAL(value, copy.toValue());
+  copy = Json::FrozenValue(Json::Value(7));
+  JSONTEST_ASSERT_EQUAL(7, copy.asInt());
+  JSONTEST_ASSERT(copy.begin() == copy.end());
+  JSONTEST_ASSERT_EQUAL(value, moved.toValue());
+}
+
+JSONTEST_FIXTURE(FrozenValueTest, parse) {
+  Json::CharReaderBuilder b;
+  Json::FrozenValue root;
+  JSONCPP_STRING errs;
+  const char doc[] = "[{\"a\": 1, \"b\": \"x\"}, {\"b\": \"y\", \"a\": 2}]";
+  bool ok = Json::FrozenValue::parse(b, doc, doc + sizeof(doc) - 1, &root,
+                                     &errs);
+  JSONTEST_ASSERT(ok);
+  JSONTEST_ASSERT(errs.empty());
+  JSONTEST_ASSERT_EQUAL(2u, root.size());
+  JSONTEST_ASSERT_EQUAL(2, root[1]["a"].asInt());
+  JSONTEST_ASSERT_EQUAL("y", root[1]["b"].asString());
+  // Both objects share one copy of each name.
+  const char* end;
+  JSONTEST_ASSERT(root[0].begin().memberName(&end) ==
+                  root[1].begin().memberName(&end));
+
+  const char bad[] = "[1, }";
+  ok = Json::FrozenValue::parse(b, bad, bad + sizeof(bad) - 1, &root, &errs);
+  JSONTEST_ASSERT(!ok);
+  JSONTEST_ASSERT(!errs.empty());
+  JSONTEST_ASSERT_EQUAL(2u, root.size()); // unchanged
+}
+
+JSONTEST_FIXTURE(FrozenValueTest, snapshot) {
+  Json::Value value;
+  value["name"] = "a string too long to be inlined";
+  for (int i = 0; i < 10; ++i)
+    value["list"].append(i * 0.5);
+  const char* path = "frozen_value_test.tape";
+  {
+    std::ofstream out(path, std::ios::binary);
+    Json::FrozenValue(value).writeSnapshot(out);
+    JSONTEST_ASSERT(out.good());
+  }
+
+  Json::FrozenSnapshot snapshot;
+  JSONCPP_STRING errs;
+  JSONTEST_ASSERT(snapshot.isNull());
+  JSONTEST_ASSERT(snapshot.open(path, &errs));
+  JSONTEST_ASSERT_EQUAL(Json::FrozenValue(value).byteSize(),
+                        snapshot.byteSize());
+  JSONTEST_ASSERT_EQUAL(4.5, snapshot["list"][9].asDouble());
+  JSONTEST_ASSERT_EQUAL(value, snapshot.toValue());
+  Json::FrozenSnapshot moved(std::move(snapshot));
+  JSONTEST_ASSERT(snapshot.isNull());
+  JSONTEST_ASSERT_EQUAL("a string too long to be inlined",
+                        moved["name"].asString());
+  moved.close();
+  JSONTEST_ASSERT(moved.isNull());
+
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "{\"not\": \"a snapshot, but long enough to be taken for one\"}";
+  }
+  JSONTEST_ASSERT(!snapshot.open(path, &errs));
+  JSONTEST_ASSERT_STRING_EQUAL(JSONCPP_STRING(path) + " is not a snapshot",
+                               errs);
+  {
+    std::ofstream out(path, std::ios::binary);
+    Json::FrozenValue(value).writeSnapshot(out);
+    out << "trailing";
+  }
+  JSONTEST_ASSERT(!snapshot.open(path, &errs));
+  JSONTEST_ASSERT_STRING_EQUAL(JSONCPP_STRING(path) +
+                                   " is a snapshot of the wrong size",
+                               errs);
+  std::remove(path);
+  JSONTEST_ASSERT(!snapshot.open(path, &errs));
+  JSONTEST_ASSERT(snapshot.isNull());
+}
+
+struct ColumnarViewTest : JsonTest::TestCase {};
+
+JSONTEST_FIXTURE(ColumnarViewTest, fromValue) {
+  Json::Value records(Json::arrayValue);
+  for (int i = 0; i < 70; ++i) {
+    Json::Value& record = records.append(Json::objectValue);
+    record["id"] = i;
+    record["price"] = i % 2 ? Json::Value(i * 0.5) : Json::Value(i / 2);
+    if (i % 3)
+      record["name"] = "item" + std::to_string(i);
+    record["pos"]["x"] = -i;
+    record["pos"]["big"] = Json::UInt64(9223372036854775808u) + Json::UInt64(i);
+    record["flag"] = i % 2 == 0;
+    record["mixed"] = i % 5 ? Json::Value(i) : Json::Value("five");
+    record["list"].append(i);
+    record["none"] = Json::Value();
+  }
+  records.append(42); // a row of nulls
+
+  Json::ColumnarView view(records);
+  JSONTEST_ASSERT_EQUAL(71u, view.rows());
+  JSONTEST_ASSERT_EQUAL(7u, view.columns());
+  // Members are met in name order, record after record.
+  JSONTEST_ASSERT_STRING_EQUAL("flag", view[0].path());
+  JSONTEST_ASSERT_STRING_EQUAL("name", view[6].path());
+  JSONTEST_ASSERT(view.find("mixed") == NULL);
+  JSONTEST_ASSERT(view.find("list") == NULL);
+  JSONTEST_ASSERT(view.find("pos") == NULL);
+
+  const Json::ColumnarView::Column* id = view.find("id");
+  JSONTEST_ASSERT_EQUAL(Json::intValue, id->type());
+  JSONTEST_ASSERT_EQUAL(71u, id->size());
+  JSONTEST_ASSERT_EQUAL(69, id->ints()[69]);
+  JSONTEST_ASSERT(id->reals() == NULL);
+  JSONTEST_ASSERT(!id->isNull(69));
+  JSONTEST_ASSERT(id->isNull(70));
+  JSONTEST_ASSERT_EQUAL(0u, id->validity()[1] >> 6);
+
+  const Json::ColumnarView::Column* price = view.find("price");
+  JSONTEST_ASSERT_EQUAL(Json::realValue, price->type());
+  double total = 0;
+  for (Json::ArrayIndex row = 0; row < view.rows(); ++row)
+    total += price->reals()[row];
+  JSONTEST_ASSERT_EQUAL(1207.5, total);
+
+  const Json::ColumnarView::Column* name = view.find("name");
+  JSONTEST_ASSERT_EQUAL(Json::stringValue, name->type());
+  JSONTEST_ASSERT(name->isNull(3));
+  char const* begin;
+  char const* end;
+  JSONTEST_ASSERT(name->getString(4, &begin, &end));
+  JSONTEST_ASSERT_STRING_EQUAL("item4", JSONCPP_STRING(begin, end));
+  JSONTEST_ASSERT(name->getString(3, &begin, &end));
+  JSONTEST_ASSERT(begin == end);
+  JSONTEST_ASSERT_EQUAL(name->offsets()[70], name->offsets()[71]);
+  JSONTEST_ASSERT_EQUAL(Json::Value("item5"), name->value(5));
+  JSONTEST_ASSERT_EQUAL(Json::Value(), name->value(6));
+
+  JSONTEST_ASSERT_EQUAL(Json::intValue, view.find("pos.x")->type());
+  JSONTEST_ASSERT_EQUAL(-7, view.find("pos.x")->ints()[7]);
+  const Json::ColumnarView::Column* big = view.find("pos.big");
+  JSONTEST_ASSERT_EQUAL(Json::uintValue, big->type());
+  JSONTEST_ASSERT_EQUAL(Json::UInt64(9223372036854775810u), big->uints()[2]);
+  JSONTEST_ASSERT_EQUAL(Json::booleanValue, view.find("flag")->type());
+  JSONTEST_ASSERT_EQUAL(1, view.find("flag")->bools()[4]);
+  JSONTEST_ASSERT_EQUAL(Json::nullValue, view.find("none")->type());
+  JSONTEST_ASSERT(view.find("none")->isNull(0));
+
+  // Copies hold columns of their own.
+  Json::ColumnarView copy(view);
+  view = Json::ColumnarView();
+  JSONTEST_ASSERT_EQUAL(0u, view.columns());
+  JSONTEST_ASSERT_EQUAL(Json::Value(68), copy.find("id")->value(68));
+}
+
+JSONTEST_FIXTURE(ColumnarViewTest, parse) {
+  Json::CharReaderBuilder b;
+  Json::ColumnarView view;
+  JSONCPP_STRING errs;
+  const char doc[] = "[{\"a\": 1, \"b\": \"x\"}, {\"b\": \"y\", \"a\": 2.5}]";
+  JSONTEST_ASSERT(
+      Json::ColumnarView::parse(b, doc, doc + sizeof(doc) - 1, &view, &errs));
+  JSONTEST_ASSERT_EQUAL(2u, view.rows());
+  JSONTEST_ASSERT_EQUAL(2.5, view.find("a")->reals()[1]);
+  JSONTEST_ASSERT_EQUAL(Json::Value("y"), view.find("b")->value(1));
+
+  // A '.' in a name is escaped in paths: these make two columns.
+  const char dotted[] = "[{\"a.b\": \"x\", \"a\": {\"b\": \"y\"}}]";
+  Json::ColumnarView paths;
+  JSONTEST_ASSERT(Json::ColumnarView::parse(
+      b, dotted, dotted + sizeof(dotted) - 1, &paths, &errs));
+  JSONTEST_ASSERT_EQUAL(2u, paths.columns());
+  JSONTEST_ASSERT_EQUAL(Json::Value("y"), paths.find("a.b")->value(0));
+  JSONTEST_ASSERT_EQUAL(Json::Value("x"), paths.find("a\\.b")->value(0));
+
+  const char object[] = "{\"a\": 1}";
+  JSONTEST_ASSERT(!Json::ColumnarView::parse(
+      b, object, object + sizeof(object) - 1, &view, &errs));
+  JSONTEST_ASSERT_STRING_EQUAL("The document is not an array of records",
+                               errs);
+  JSONTEST_ASSERT_EQUAL(2u, view.rows()); // unchanged
+}
+
 int main(int argc, const char* argv[]) {
   JsonTest::Runner runner;
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, checkNormalizeFloatingPointStr);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, memberCount);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, objects);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, objectGrowAndShrink);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, largeObjects);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, arrays);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, arrayIssue252);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, arrayGrowAndShrink);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, arrayBulkMutations);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, null);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, strings);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, shortStrings);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, bools);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, integers);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, nonIntegers);
@@ -3093,6 +4673,18 @@ int main(int argc, const char* argv[]) {
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, compareObject);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, compareType);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, offsetAccessors);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, compactLayout);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, copyOnWrite);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, moveInsertion);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, reserve);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, keyLookups);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, forEachMember);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, mergePatch);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, memoryUsage);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, hash);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, reset);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, arena);
+  JSONTEST_REGISTER_FIXTURE(runner, ValueTest, deferredRelease);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, typeChecksThrowExceptions);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, StaticString);
   JSONTEST_REGISTER_FIXTURE(runner, ValueTest, CommentBefore);
@@ -3136,10 +4728,20 @@ int main(int argc, const char* argv[]) {
   JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithNoErrors);
   JSONTEST_REGISTER_FIXTURE(
       runner, CharReaderTest, parseWithNoErrorsTestingOffsets);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithoutOffsets);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithInternedKeys);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithSizeHints);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithLazyNumbers);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithLazyStrings);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithReuse);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseIntoArena);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithPackedNumbers);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithSharedShapes);
   JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithOneError);
   JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseChineseWithOneError);
   JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithDetailError);
   JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseWithStackLimit);
+  JSONTEST_REGISTER_FIXTURE(runner, CharReaderTest, parseCommentsOnReorderedMembers);
 
   JSONTEST_REGISTER_FIXTURE(runner, CharReaderStrictModeTest, dupKeys);
 
@@ -3166,5 +4768,11 @@ int main(int argc, const char* argv[]) {
 
   JSONTEST_REGISTER_FIXTURE(runner, RValueTest, moveConstruction);
 
+  JSONTEST_REGISTER_FIXTURE(runner, FrozenValueTest, fromValue);
+  JSONTEST_REGISTER_FIXTURE(runner, FrozenValueTest, parse);
+  JSONTEST_REGISTER_FIXTURE(runner, FrozenValueTest, snapshot);
+  JSONTEST_REGISTER_FIXTURE(runner, ColumnarViewTest, fromValue);
+  JSONTEST_REGISTER_FIXTURE(runner, ColumnarViewTest, parse);
+
   return runner.runCommandLine(argc, argv);
 }